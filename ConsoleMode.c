@@ -1,8 +1,10 @@
+#define _POSIX_C_SOURCE 200112L //for sigaction
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 #include <ctype.h>
+#include <signal.h>
 #include "Parser.h"
 #include "SPArrayList.h"
 #include "SPChessGame.h"
@@ -13,6 +15,8 @@
 
 #define HISTORY_SIZE 6
 
+static SPMinimaxHandle computerSearch; //the search of the computer turn
+
 /********************Prototypes**************************/
 
 void printFuncErr(char *funcName);
@@ -29,11 +33,13 @@ void printCurrentPlayerInCheck (SPChessGame *game);
 SP_CHESS_GAME_MESSAGE handleMoveCommand(SPChessGame *game, CCommand command);
 void printGetMoves (SPMove *moves, int len);
 SP_GAME_STATUS handleGetMovesCommand(SPChessGame *game, CCommand command);
+SP_GAME_STATUS handleStatsCommand();
 SP_GAME_STATUS handleUndoCommand(SPChessGame *game, bool print);
 SP_GAME_STATUS handleSaveCommand(SPChessGame *src, CCommand comm, bool print);
 SP_GAME_STATUS playerTurn(SPChessGame *game);
 void printGameOver(int winner);
 SP_GAME_STATUS play(SPChessGame *game);
+void stopComputerSearch(int sig);
 
 /*******************Implementation***********************/
 
@@ -316,6 +322,34 @@ SP_GAME_STATUS handleSaveCommand(SPChessGame *src, CCommand comm, bool print){
 	return SP_GAME_STATUS_SUCCESS;
 }
 
+/** Prints the statistics of the last computer search:
+ * the depth, the nodes and the time of the search, how well the moves were ordered
+ * (the share of the cut-offs caused by the first move, and the average number of moves searched in a node),
+ * and the hits of the transposition table.
+ * prints "No search has been made" - if the computer hasn't searched yet
+ *
+ * @return SP_GAME_STATUS_SUCCESS
+ */
+SP_GAME_STATUS handleStatsCommand(){
+	SPMinimaxStats stats = spMinimaxGetStats();
+	if (stats.nodes == 0){
+		printf("No search has been made\n");
+		return SP_GAME_STATUS_SUCCESS;
+	}
+	printf("Depth: %d, max ply: %d\n", stats.depth, stats.maxPly);
+	printf("Nodes: %llu, leaf evaluations: %llu\n", stats.nodes, stats.leafEvals);
+	printf("Time: %lld ms, %llu nodes per second\n", stats.elapsedMs,
+			(stats.elapsedMs > 0) ? stats.nodes*1000/stats.elapsedMs : stats.nodes*1000);
+	printf("Beta cut-offs: %llu, %.1f%% by the first move\n", stats.betaCutoffs,
+			(stats.betaCutoffs > 0) ? 100.0*stats.firstMoveCutoffs/stats.betaCutoffs : 0.0);
+	printf("Branching factor: %.2f\n",
+			(stats.interiorNodes > 0) ? (double)stats.movesSearched/stats.interiorNodes : 0.0);
+	if (stats.ttProbes > 0){
+		printf("Hash hits: %llu of %llu probes (%.1f%%)\n", stats.ttHits, stats.ttProbes, 100.0*stats.ttHits/stats.ttProbes);
+	}
+	return SP_GAME_STATUS_SUCCESS;
+}
+
 /** Restarts the game with the current game settings
  *
  * @param src - the game source
@@ -361,6 +395,9 @@ SP_GAME_STATUS handlePlayerCommand(SPChessGame *game, CCommand command, bool pri
 	else if (command.cmd == SAVE){
 		return handleSaveCommand(game, command, print);
 	}
+	else if (command.cmd == STATS){
+		return handleStatsCommand();
+	}
 	if (print){
 		printInvalidCommandErr();
 	}
@@ -392,11 +429,24 @@ SP_GAME_STATUS playerTurn(SPChessGame *game){
 	return status;
 }
 
+/**
+ * The SIGINT handler while the computer searches: stops the search of the computer turn
+ *
+ * @param sig - the signal number
+ */
+void stopComputerSearch(int sig){
+	(void)sig;
+	spMinimaxStopSearch(&computerSearch);
+}
+
 /**
  * Makes the computer turn,
  * prints "Computer: move [pawn|bishop|knight|rook|queen] at <x,y> to <i,j>".
  * where each move is represented by the original position <x,y>
  * and the destination <i,j>.
+ * While the computer searches, SIGINT (Ctrl-C) stops the search,
+ * and the best move found so far is played. The handler stays installed until the search returns,
+ * so another Ctrl-C during the same search doesn't terminate the program.
  *
  * @param game - the source game
  * @bool print - whether to print a message or not
@@ -408,7 +458,18 @@ SP_GAME_STATUS playerTurn(SPChessGame *game){
 SP_GAME_STATUS computerTurn(SPChessGame *game, bool print){
 
 	SPMove move;
-	move = spMinimaxSuggestMove(game, game->difficulty);
+	struct sigaction action, prevAction;
+	bool isInstalled;
+	spMinimaxInitHandle(&computerSearch, NULL, NULL);
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stopComputerSearch;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = 0; //not SA_RESETHAND, so the handler isn't reset when it is called
+	isInstalled = (sigaction(SIGINT, &action, &prevAction) == 0);
+	move = spMinimaxSuggestMove(game, game->difficulty, &computerSearch);
+	if (isInstalled){
+		sigaction(SIGINT, &prevAction, NULL);
+	}
 	if (move.start.row == -1){
 		return SP_GAME_STATUS_MALLOC_ERR;
 	}
@@ -454,6 +515,7 @@ void printGameOver(int winner){
 SP_GAME_STATUS play(SPChessGame *game){
 	if (game->game_mode == 1){ //1-Player mode
 		if(spChessGameGetCurrentPlayer(game) == game->userColor){	//player turn
+			spMinimaxStartPondering(game); //search the computer's reply while the user thinks
 			return playerTurn(game);
 		}
 		return computerTurn(game, true);	//computer turn
@@ -543,5 +605,6 @@ SP_GAME_STATUS consoleMain(){
 	}
 	//free resources
 	spChessGameDestroy(game);
+	spMinimaxCleanup();
 	return status;
 }
@@ -45,6 +45,8 @@ SP_GAME_STATUS handlePlayerCommand(SPChessGame *game, CCommand command, bool pri
  * prints "Computer: move [pawn|bishop|knight|rook|queen] at <x,y> to <i,j>".
  * where each move is represented by the original position <x,y>
  * and the destination <i,j>.
+ * While the computer searches, SIGINT (Ctrl-C) stops the search,
+ * and the best move found so far is played.
  *
  * @param game - the source game
  * @bool print - whether to print a message or not
@@ -3,6 +3,7 @@
 #include "SPChessGame.h"
 #include "Parser.h"
 #include "ConsoleMode.h"
+#include "SPMinimax.h"
 #include "GUI_MessageBox.h"
 #include "UI_Window.h"
 #include "UI_Button.h"
@@ -286,6 +287,9 @@ int setComputerMove(SPChessGame *game){
 		}
 
 	}
+	if (!game->isOver && game->game_mode == 1 && game->currentPlayer == game->userColor){ //user turn
+		spMinimaxStartPondering(game); //search the computer's reply while the user thinks
+	}
 	return 0;
 }
 
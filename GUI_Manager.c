@@ -13,6 +13,7 @@
 #include "GUI_GameWindow.h"
 #include "GUI_Manager.h"
 #include "GUI_MessageBox.h"
+#include "SPMinimax.h"
 
 //globals
 int exitLoop = 0;
@@ -140,6 +141,7 @@ void quitGame(){
 /** Destroys all resources used by the program*/
 void destroyAllResources(){
 	spChessGameDestroy(game);
+	spMinimaxCleanup();
 	destroyWidget(mainMenuWindow);
 	destroyWidget(gameModeWindow);
 	destroyWidget(difficultyWindow);
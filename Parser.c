@@ -19,6 +19,7 @@
 #define UNDO_TXT "undo"
 #define QUIT_TXT "quit"
 #define RESET_TXT "reset"
+#define STATS_TXT "stats"
 #define SET_MODE_TXT "game_mode"
 #define SET_DIFF_TXT "difficulty"
 #define SET_COLOR_TXT "user_color"
@@ -230,6 +231,9 @@ bool cParserWithoutArg(CCommand* command){
 	else if(command->cmd == RESET){
 		return true;
 	}
+	else if(command->cmd == STATS){
+		return true;
+	}
 	else if(command->cmd == INVALID_LINE){
 		return true;
 	}
@@ -259,6 +263,9 @@ COMMAND cParserParseCommand(const char* str){
 	if (strcmp(str, RESET_TXT)==0){
 		return RESET;
 	}
+	if (strcmp(str, STATS_TXT)==0){
+		return STATS;
+	}
 	if (strcmp(str, SAVE_TXT)==0){
 		return SAVE;
 	}
@@ -24,6 +24,7 @@ typedef enum {
 	UNDO,
 	RESET,
 	QUIT,
+	STATS,
 	INVALID_LINE,
 
 	SET_MODE,
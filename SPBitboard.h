@@ -0,0 +1,112 @@
+#ifndef SPBITBOARD_H_
+#define SPBITBOARD_H_
+
+#include <stdint.h>
+
+/**
+ * SPBitboard Summary:
+ *
+ * A set of squares of the 8 by 8 game board packed into a 64 bit word.
+ * The square at (row, col) is represented by the bit number row*8+col,
+ * so bit 0 is the upper left corner of the board (<8,A>) and bit 63 is
+ * the lower right corner (<1,H>).
+ *
+ * spBitboardSquare          - Returns the square index of a board location
+ * spBitboardRow             - Returns the row of a square index
+ * spBitboardCol             - Returns the column of a square index
+ * spBitboardMask            - Returns a bitboard containing a single square
+ * spBitboardCount           - Returns the number of squares in a bitboard
+ * spBitboardFirstSquare     - Returns the lowest square in a bitboard
+ * spBitboardLastSquare      - Returns the highest square in a bitboard
+ * spBitboardPopFirstSquare  - Removes and returns the lowest square in a bitboard
+ */
+
+//Definitions
+#define SP_BITBOARD_N_ROWS 8
+#define SP_BITBOARD_N_COLUMNS 8
+#define SP_BITBOARD_N_SQUARES 64
+#define SP_BITBOARD_EMPTY ((SPBitboard)0)
+
+/**
+ * Type used to represent a set of squares on the board
+ */
+typedef uint64_t SPBitboard;
+
+/** Returns the square index of the specified board location
+ * @param row, col - the location on the board (0-based)
+ * @return
+ * row*8+col
+ */
+static inline int spBitboardSquare(int row, int col){
+	return row*SP_BITBOARD_N_COLUMNS + col;
+}
+
+/** Returns the row of the specified square index
+ * @param square - the square index
+ * @return
+ * the row of the square (0-based)
+ */
+static inline int spBitboardRow(int square){
+	return square/SP_BITBOARD_N_COLUMNS;
+}
+
+/** Returns the column of the specified square index
+ * @param square - the square index
+ * @return
+ * the column of the square (0-based)
+ */
+static inline int spBitboardCol(int square){
+	return square%SP_BITBOARD_N_COLUMNS;
+}
+
+/** Returns a bitboard which contains only the specified square
+ * @param square - the square index
+ * @return
+ * a bitboard with the bit of the square set
+ */
+static inline SPBitboard spBitboardMask(int square){
+	return ((SPBitboard)1) << square;
+}
+
+/** Returns the number of squares in the specified bitboard
+ * @param board - the bitboard
+ * @return
+ * the number of set bits in board
+ */
+static inline int spBitboardCount(SPBitboard board){
+	return __builtin_popcountll(board);
+}
+
+/** Returns the lowest square in the specified bitboard
+ * @pre board != SP_BITBOARD_EMPTY
+ * @param board - the bitboard
+ * @return
+ * the index of the lowest set bit in board
+ */
+static inline int spBitboardFirstSquare(SPBitboard board){
+	return __builtin_ctzll(board);
+}
+
+/** Returns the highest square in the specified bitboard
+ * @pre board != SP_BITBOARD_EMPTY
+ * @param board - the bitboard
+ * @return
+ * the index of the highest set bit in board
+ */
+static inline int spBitboardLastSquare(SPBitboard board){
+	return SP_BITBOARD_N_SQUARES - 1 - __builtin_clzll(board);
+}
+
+/** Removes the lowest square from the specified bitboard
+ * @pre *board != SP_BITBOARD_EMPTY
+ * @param board - pointer to the bitboard
+ * @return
+ * the index of the square that has been removed
+ */
+static inline int spBitboardPopFirstSquare(SPBitboard *board){
+	int square = __builtin_ctzll(*board);
+	*board &= *board - 1;
+	return square;
+}
+
+#endif /* SPBITBOARD_H_ */
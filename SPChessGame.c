@@ -15,6 +15,13 @@ bool isLegalCoord (SPCoordinate coord);
 bool isLegalMoveCoordinates (SPMove move);
 char unParseRow (int row);
 char unParseColumn (int col);
+uint64_t nextZobristKey(uint64_t *seed);
+void initZobristKeys();
+SPBitboard stepAttacks(int row, int col, const int offsets[][2], int nOffsets);
+SPBitboard rayAttacks(int row, int col, int deltaRow, int deltaCol);
+void initAttackTables();
+SPBitboard slidingAttacks(SPBitboard rays[4][SP_BITBOARD_N_SQUARES], const int directions[4][2], int square, SPBitboard occupied);
+void clearBoard(SPChessGame* src);
 void initializeBord(SPChessGame* game);
 void initPawns (SPChessGame* src);
 void initRow(SPChessGame* src, int row, int color);
@@ -23,6 +30,8 @@ void applyMove (SPChessGame* src, SPMove move);
 bool doesMoveCapturePiece (SPChessGame *src, SPMove move);
 bool canPlayerMoveTo(SPChessGame *src, SPCoordinate dest, int playerColor);
 SPCoordinate findKingLocation (SPChessGame *src, int playerColor);
+SPBitboard getAttackers (SPChessGame *src, int square, int enemyColor, SPBitboard occupied);
+bool isKingThrethened(SPChessGame *src, SPCoordinate coordinate);
 bool spChessIsPlayerInCheckMate(SPChessGame *src, int playerColor);
 bool spChessIsPlayerInDraw(SPChessGame* src, int playerColor);
 bool wouldCauseCheck(SPMove move, int color, SPChessGame *src);
@@ -34,12 +43,261 @@ SP_CHESS_GAME_MESSAGE spChessGameIsValidMoveKnight(SPChessGame *src, SPMove move
 SP_CHESS_GAME_MESSAGE spChessGameIsValidMovePawn(SPChessGame *src, SPMove move);
 SP_CHESS_GAME_MESSAGE spChessGameIsValidMoveQueen(SPChessGame *src, SPMove move);
 SP_CHESS_GAME_MESSAGE spChessGameIsValidMoveGeneric(SPChessGame *src, SPMove move);
-void setPieceAt (SPChessGame *src, char piece, int row, int col);
+void computeLegalityInfo (SPChessGame *src, int color, SPLegalityInfo *info);
+bool isMoveLegal (SPChessGame *src, SPMove move, const SPLegalityInfo *info);
+int addLegalMove (SPChessGame *src, SPMove move, const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity);
+int addLegalMovesTo (SPChessGame *src, int square, SPBitboard targets, const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity);
+int generateStepMoves (SPChessGame *src, int row, int col, const SPBitboard attacks[SP_BITBOARD_N_SQUARES], const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity);
+int generateSlidingMoves (SPChessGame *src, int row, int col, SPBitboard rays[4][SP_BITBOARD_N_SQUARES], const int directions[4][2], const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity);
+int generatePawnMoves (SPChessGame *src, int row, int col, const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity);
+int generatePieceMoves (SPChessGame *src, int row, int col, const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity);
+bool shouldGenerateEvasions (SPChessGame *src, const SPLegalityInfo *info);
+int generatePawnBlocks (SPChessGame *src, int square, const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity);
+int generateEvasions (SPChessGame *src, const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity);
+void sortMovesByBoardOrder (SPMove *moves, int size);
 int getPieceScore(char piece);
+int getPieceSquareScore(SPPieceType type, int color, int square);
 int scoreFunc (void* src);
 
+/*******************Tables*******************************/
+
+/** The {deltaRow, deltaCol} offsets of the squares a knight can reach */
+static const int knightOffsets[8][2] = {{-2,-1}, {-2,1}, {-1,-2}, {-1,2}, {1,-2}, {1,2}, {2,-1}, {2,1}};
+
+/** The {deltaRow, deltaCol} offsets of the squares a king can reach */
+static const int kingOffsets[8][2] = {{-1,-1}, {-1,0}, {-1,1}, {0,-1}, {0,1}, {1,-1}, {1,0}, {1,1}};
+
+/** The {deltaRow, deltaCol} directions a rook slides in */
+static const int rookDirections[4][2] = {{-1,0}, {1,0}, {0,-1}, {0,1}};
+
+/** The {deltaRow, deltaCol} directions a bishop slides in */
+static const int bishopDirections[4][2] = {{-1,-1}, {-1,1}, {1,-1}, {1,1}};
+
+/** The piece-square scores of every piece type (indexed by SPPieceType) on every square,
+ *  in hundredths of a pawn, as seen by the white player: row 0 is the row the white pawns move towards.
+ *  The scores of a black piece are taken from the square mirrored across the middle of the board */
+static const int pieceSquareScores[SP_CHESS_GAME_N_PIECE_TYPES][SP_BITBOARD_N_SQUARES] = {
+	{ //PAWN
+		  0,  0,  0,  0,  0,  0,  0,  0,
+		 50, 50, 50, 50, 50, 50, 50, 50,
+		 10, 10, 20, 30, 30, 20, 10, 10,
+		  5,  5, 10, 25, 25, 10,  5,  5,
+		  0,  0,  0, 20, 20,  0,  0,  0,
+		  5, -5,-10,  0,  0,-10, -5,  5,
+		  5, 10, 10,-20,-20, 10, 10,  5,
+		  0,  0,  0,  0,  0,  0,  0,  0
+	},
+	{ //BISHOP
+		-20,-10,-10,-10,-10,-10,-10,-20,
+		-10,  0,  0,  0,  0,  0,  0,-10,
+		-10,  0,  5, 10, 10,  5,  0,-10,
+		-10,  5,  5, 10, 10,  5,  5,-10,
+		-10,  0, 10, 10, 10, 10,  0,-10,
+		-10, 10, 10, 10, 10, 10, 10,-10,
+		-10,  5,  0,  0,  0,  0,  5,-10,
+		-20,-10,-10,-10,-10,-10,-10,-20
+	},
+	{ //ROOK
+		  0,  0,  0,  0,  0,  0,  0,  0,
+		  5, 10, 10, 10, 10, 10, 10,  5,
+		 -5,  0,  0,  0,  0,  0,  0, -5,
+		 -5,  0,  0,  0,  0,  0,  0, -5,
+		 -5,  0,  0,  0,  0,  0,  0, -5,
+		 -5,  0,  0,  0,  0,  0,  0, -5,
+		 -5,  0,  0,  0,  0,  0,  0, -5,
+		  0,  0,  0,  5,  5,  0,  0,  0
+	},
+	{ //KNIGHT
+		-50,-40,-30,-30,-30,-30,-40,-50,
+		-40,-20,  0,  0,  0,  0,-20,-40,
+		-30,  0, 10, 15, 15, 10,  0,-30,
+		-30,  5, 15, 20, 20, 15,  5,-30,
+		-30,  0, 15, 20, 20, 15,  0,-30,
+		-30,  5, 10, 15, 15, 10,  5,-30,
+		-40,-20,  0,  5,  5,  0,-20,-40,
+		-50,-40,-30,-30,-30,-30,-40,-50
+	},
+	{ //QUEEN
+		-20,-10,-10, -5, -5,-10,-10,-20,
+		-10,  0,  0,  0,  0,  0,  0,-10,
+		-10,  0,  5,  5,  5,  5,  0,-10,
+		 -5,  0,  5,  5,  5,  5,  0, -5,
+		  0,  0,  5,  5,  5,  5,  0, -5,
+		-10,  5,  5,  5,  5,  5,  0,-10,
+		-10,  0,  5,  0,  0,  0,  0,-10,
+		-20,-10,-10, -5, -5,-10,-10,-20
+	},
+	{ //KING
+		-30,-40,-40,-50,-50,-40,-40,-30,
+		-30,-40,-40,-50,-50,-40,-40,-30,
+		-30,-40,-40,-50,-50,-40,-40,-30,
+		-30,-40,-40,-50,-50,-40,-40,-30,
+		-20,-30,-30,-40,-40,-30,-30,-20,
+		-10,-20,-20,-20,-20,-20,-20,-10,
+		 20, 20,  0,  0,  0,  0, 20, 20,
+		 20, 30, 10,  0,  0, 10, 30, 20
+	}
+};
+
+/** Zobrist keys of every piece type of each color on every square, and of the black player's turn.
+ *  Filled once by initZobristKeys */
+static uint64_t zobristPieceKeys[2][SP_CHESS_GAME_N_PIECE_TYPES][SP_BITBOARD_N_SQUARES];
+static uint64_t zobristBlackToMoveKey;
+static bool zobristKeysInitialized = false;
+
+/** The squares a knight, a king and a pawn of each color attack from every square.
+ *  Filled once by initAttackTables */
+static SPBitboard knightAttacks[SP_BITBOARD_N_SQUARES];
+static SPBitboard kingAttacks[SP_BITBOARD_N_SQUARES];
+static SPBitboard pawnAttacks[2][SP_BITBOARD_N_SQUARES];
+
+/** The square a pawn of each color moves to from every square when it moves one square forward
+ *  (empty on the last row of the pawn). Filled once by initAttackTables */
+static SPBitboard pawnPushes[2][SP_BITBOARD_N_SQUARES];
+
+/** The squares from every square to the edge of the board in each of the rookDirections
+ *  and bishopDirections, and the squares strictly between every two squares on a common
+ *  row, column or diagonal (empty for other pairs). Filled once by initAttackTables */
+static SPBitboard rookRays[4][SP_BITBOARD_N_SQUARES];
+static SPBitboard bishopRays[4][SP_BITBOARD_N_SQUARES];
+static SPBitboard squaresBetween[SP_BITBOARD_N_SQUARES][SP_BITBOARD_N_SQUARES];
+static bool attackTablesInitialized = false;
+
 /*******************Implementation***********************/
 
+/** Returns the next pseudo random number of the splitmix64 generator
+ *  @param seed - pointer to the generator state, advanced by the function
+ *  @return
+ *  a pseudo random 64 bit number
+ */
+uint64_t nextZobristKey(uint64_t *seed){
+	uint64_t z = (*seed += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/** Fills the Zobrist keys tables with pseudo random numbers (splitmix64).
+ *  The numbers are the same on every run, so the keys of a position are reproducible.
+ *  Does nothing if the tables were already filled.
+ */
+void initZobristKeys(){
+	uint64_t seed = 0x2545F4914F6CDD1DULL;
+	if (zobristKeysInitialized){
+		return;
+	}
+	for (int color=0; color<2; color++){
+		for (int type=0; type<SP_CHESS_GAME_N_PIECE_TYPES; type++){
+			for (int square=0; square<SP_BITBOARD_N_SQUARES; square++){
+				zobristPieceKeys[color][type][square] = nextZobristKey(&seed);
+			}
+		}
+	}
+	zobristBlackToMoveKey = nextZobristKey(&seed);
+	zobristKeysInitialized = true;
+}
+
+/** Returns the squares on the board which are reached from the specified location
+ *  by the specified offsets
+ *  @param row, col - the location on the board
+ *  @param offsets - the {deltaRow, deltaCol} offsets
+ *  @param nOffsets - the number of offsets
+ *  @return
+ *  a bitboard of the squares reached
+ */
+SPBitboard stepAttacks(int row, int col, const int offsets[][2], int nOffsets){
+	SPBitboard res = SP_BITBOARD_EMPTY;
+	for (int i=0; i<nOffsets; i++){
+		SPCoordinate coord = {.row = row+offsets[i][0], .col = col+offsets[i][1]};
+		if (isLegalCoord(coord)){
+			res |= spBitboardMask(spBitboardSquare(coord.row, coord.col));
+		}
+	}
+	return res;
+}
+
+/** Returns the squares on the board from the specified location (not included)
+ *  to the edge of the board in the specified direction
+ *  @param row, col - the location on the board
+ *  @param deltaRow, deltaCol - the direction
+ *  @return
+ *  a bitboard of the squares on the ray
+ */
+SPBitboard rayAttacks(int row, int col, int deltaRow, int deltaCol){
+	SPBitboard res = SP_BITBOARD_EMPTY;
+	SPCoordinate coord = {.row = row+deltaRow, .col = col+deltaCol};
+	while (isLegalCoord(coord)){
+		res |= spBitboardMask(spBitboardSquare(coord.row, coord.col));
+		coord.row += deltaRow;
+		coord.col += deltaCol;
+	}
+	return res;
+}
+
+/** Fills the knight, king and pawn attack tables, the pawn pushes table, the rays tables and the squaresBetween table.
+ *  A white pawn moves up and attacks the squares diagonally above it, and a black pawn the squares below it.
+ *  Does nothing if the tables were already filled.
+ */
+void initAttackTables(){
+	static const int whitePawnOffsets[2][2] = {{-1,-1}, {-1,1}};
+	static const int blackPawnOffsets[2][2] = {{1,-1}, {1,1}};
+	static const int whitePawnPush[1][2] = {{-1,0}};
+	static const int blackPawnPush[1][2] = {{1,0}};
+	if (attackTablesInitialized){
+		return;
+	}
+	for (int square=0; square<SP_BITBOARD_N_SQUARES; square++){
+		int row = spBitboardRow(square), col = spBitboardCol(square);
+		knightAttacks[square] = stepAttacks(row, col, knightOffsets, 8);
+		kingAttacks[square] = stepAttacks(row, col, kingOffsets, 8);
+		pawnAttacks[SP_CHESS_GAME_WHITE][square] = stepAttacks(row, col, whitePawnOffsets, 2);
+		pawnAttacks[SP_CHESS_GAME_BLACK][square] = stepAttacks(row, col, blackPawnOffsets, 2);
+		pawnPushes[SP_CHESS_GAME_WHITE][square] = stepAttacks(row, col, whitePawnPush, 1);
+		pawnPushes[SP_CHESS_GAME_BLACK][square] = stepAttacks(row, col, blackPawnPush, 1);
+		for (int dir=0; dir<4; dir++){
+			rookRays[dir][square] = rayAttacks(row, col, rookDirections[dir][0], rookDirections[dir][1]);
+			bishopRays[dir][square] = rayAttacks(row, col, bishopDirections[dir][0], bishopDirections[dir][1]);
+		}
+	}
+	for (int square=0; square<SP_BITBOARD_N_SQUARES; square++){
+		for (int dir=0; dir<8; dir++){
+			SPBitboard (*rays)[SP_BITBOARD_N_SQUARES] = (dir < 4) ? rookRays : bishopRays;
+			SPBitboard ray = rays[dir%4][square];
+			while (ray != SP_BITBOARD_EMPTY){
+				int dest = spBitboardPopFirstSquare(&ray);
+				//the ray from square without the ray from dest is the path up to dest
+				squaresBetween[square][dest] = rays[dir%4][square] & ~rays[dir%4][dest] & ~spBitboardMask(dest);
+			}
+		}
+	}
+	attackTablesInitialized = true;
+}
+
+/** Returns the squares a sliding piece attacks from the specified square,
+ *  that is the squares on its rays up to and including the first occupied square of every ray.
+ *  @param rays - the rays of the piece (rookRays \ bishopRays)
+ *  @param directions - the directions of the rays (rookDirections \ bishopDirections)
+ *  @param square - the square of the piece
+ *  @param occupied - the occupied squares of the board
+ *  @return
+ *  a bitboard of the attacked squares
+ */
+SPBitboard slidingAttacks(SPBitboard rays[4][SP_BITBOARD_N_SQUARES], const int directions[4][2], int square, SPBitboard occupied){
+	SPBitboard res = SP_BITBOARD_EMPTY;
+	for (int dir=0; dir<4; dir++){
+		SPBitboard ray = rays[dir][square];
+		SPBitboard blockers = ray & occupied;
+		if (blockers != SP_BITBOARD_EMPTY){
+			//the first blocker is the lowest square of a ray going down or right, and the highest otherwise
+			bool isIncreasing = directions[dir][0]*SP_BITBOARD_N_COLUMNS + directions[dir][1] > 0;
+			int blocker = isIncreasing ? spBitboardFirstSquare(blockers) : spBitboardLastSquare(blockers);
+			ray &= ~rays[dir][blocker];
+		}
+		res |= ray;
+	}
+	return res;
+}
+
 /** Returns the maximum value between a and b
  * @param a
  * @param b
@@ -233,15 +491,25 @@ void initRow(SPChessGame* src, int row, int color){
 
 }
 
+/** Removes all the pieces from the board of the specified game
+ *  @param src - the source game
+ */
+void clearBoard(SPChessGame* src){
+	//the 64 bytes of the board are set at once (the compiler uses vector stores)
+	memset(src->gameBoard, SP_CHESS_GAME_EMPTY_ENTRY, sizeof(src->gameBoard));
+	memset(src->pieceBoards, 0, sizeof(src->pieceBoards)); //SP_BITBOARD_EMPTY is all zero bits
+	memset(src->colorBoards, 0, sizeof(src->colorBoards));
+	src->hashKey = 0;
+	src->score = 0;
+	src->kingSquares[SP_CHESS_GAME_BLACK] = -1;
+	src->kingSquares[SP_CHESS_GAME_WHITE] = -1;
+}
+
 /** Initializes game->gameBoard with the initial spots of the game pieces
  *  @param game - the source game
  */
 void initializeBord(SPChessGame* src){
-	for (int i=0;i<SP_CHESS_GAME_N_ROWS;i++){
-		for (int j=0;j<SP_CHESS_GAME_N_COLUMNS;j++){
-			setPieceAt(src, SP_CHESS_GAME_EMPTY_ENTRY, i, j);
-		}
-	}
+	clearBoard(src);
 	initPawns(src);
 	initRow(src,0,SP_CHESS_GAME_BLACK);
 	initRow(src,7,SP_CHESS_GAME_WHITE);
@@ -267,6 +535,8 @@ SPChessGame* spChessGameCreate(int historySize){
 	if (!game){
 		return NULL;
 	}
+	initZobristKeys();
+	initAttackTables();
 	initializeBord(game);
 	game->recentMoves = spArrayListCreate(historySize);
 	if (!game->recentMoves){
@@ -274,6 +544,7 @@ SPChessGame* spChessGameCreate(int historySize){
 		return NULL;
 	}
 	game->currentPlayer = SP_CHESS_GAME_WHITE;
+	spChessGameComputeHashKey(game);
 	game->scoreFunc = scoreFunc;
 	game->isSaved = 0;
 	game->isOver = false;
@@ -307,11 +578,12 @@ SPChessGame* spChessGameCopy(SPChessGame* src){
 	copy->isSaved = src->isSaved;
 	copy->userColor = src->userColor;
 
-	for (int i=0; i<SP_CHESS_GAME_N_ROWS; i++){
-		for (int j=0; j<SP_CHESS_GAME_N_COLUMNS; j++){
-			copy->gameBoard[i][j] = src->gameBoard[i][j];
-		}
-	}
+	memcpy(copy->gameBoard, src->gameBoard, sizeof(src->gameBoard));
+	memcpy(copy->pieceBoards, src->pieceBoards, sizeof(src->pieceBoards));
+	memcpy(copy->colorBoards, src->colorBoards, sizeof(src->colorBoards));
+	copy->hashKey = src->hashKey;
+	copy->score = src->score;
+	memcpy(copy->kingSquares, src->kingSquares, sizeof(src->kingSquares));
 
 	copy->scoreFunc = src->scoreFunc;
 	return copy;
@@ -429,6 +701,37 @@ SP_CHESS_GAME_MESSAGE spChessGameSetMove(SPChessGame* src, SPMove move){
 	return SP_CHESS_GAME_SUCCESS;
 }
 
+/**
+ * Sets the specified move and changes the current player, without adding the move
+ * to the moves history. The state needed to take the move back is stored in undo.
+ * Intended for searching, where every move is taken back by spChessGameUnmakeSearchMove.
+ *
+ * @pre the move is one of the moves returned by spChessGameGenerateAllMoves
+ * @param src - The target game
+ * @param move - The move to be applied
+ * @param undo - pointer to get the state needed to take the move back
+ */
+void spChessGameMakeSearchMove(SPChessGame* src, SPPackedMove move, SPUndoInfo *undo){
+	SPMove unpacked = spChessGameUnpackMove(move);
+	undo->move = move;
+	undo->capturedPiece = spChessGameGetPieceAt(src, unpacked.dest.row, unpacked.dest.col);
+	applyMove(src, unpacked);
+	spChessGameChangePlayer(src);
+}
+
+/**
+ * Takes back a move that has been made by spChessGameMakeSearchMove
+ * and changes the current player back.
+ *
+ * @pre undo was filled by the last spChessGameMakeSearchMove on src that wasn't taken back
+ * @param src - The target game
+ * @param undo - the state recorded when the move was made
+ */
+void spChessGameUnmakeSearchMove(SPChessGame* src, const SPUndoInfo *undo){
+	undoMove(src, spChessGameUnpackMove(undo->move), undo->capturedPiece);
+	spChessGameChangePlayer(src);
+}
+
 /** Undoes the specified move on the src game:
  * the piece at location move.dest is being moved to location move.start
  * and capturedPiece is being set at location move.dest
@@ -545,17 +848,15 @@ SP_CHESS_GAME_MESSAGE moveStatus (SPChessGame *src, SPMove move){
  *	false - otherwise
  */
 bool canPlayerMoveTo(SPChessGame *src, SPCoordinate dest, int playerColor){
-	char piece;
 	SPMove move;
 	move.dest = dest;
-	for (int i=0;i<8;i++){
-		for (int j=0;j<8;j++){
-			move.start.row = i; move.start.col = j;
-			piece = spChessGameGetPieceAt(src, i, j);
-			if (piece!='_' && spChessGameGetPieceColor(piece) == playerColor
-					&& moveStatus(src, move) ==  SP_CHESS_GAME_LEGAL_MOVE){
-				return true;
-			}
+	int square;
+	SPBitboard pieces = src->colorBoards[playerColor];
+	while (pieces != SP_BITBOARD_EMPTY){
+		square = spBitboardPopFirstSquare(&pieces);
+		move.start.row = spBitboardRow(square); move.start.col = spBitboardCol(square);
+		if (moveStatus(src, move) ==  SP_CHESS_GAME_LEGAL_MOVE){
+			return true;
 		}
 	}
 	return false;
@@ -571,276 +872,40 @@ bool canPlayerMoveTo(SPChessGame *src, SPCoordinate dest, int playerColor){
  * or {-1,-1} if the king was not found
  */
 SPCoordinate findKingLocation (SPChessGame *src, int playerColor){
-	char piece;
 	SPCoordinate res = {.row=-1, .col=-1};
-	for (int i=0;i<8;i++){
-		for (int j=0;j<8;j++){
-			piece = spChessGameGetPieceAt(src, i, j);
-			if (spChessGameGetPieceColor(piece) == playerColor && spChessGameGetPieceType(piece) == KING){
-				res.row = i;
-				res.col = j;
-				return res;
-			}
-		}
+	int square = src->kingSquares[playerColor];
+	if (square != -1){
+		res.row = spBitboardRow(square);
+		res.col = spBitboardCol(square);
 	}
 	return res;
 }
 
-/** Returns if the king at specified position is threatened by a queen, rook or bishop
+/** Returns the pieces of the specified color which attack the specified square
  *
  * @param src - the src game
- * @param coordinate - location of a king in the board
- *
- * @pre - the piece at specified location is a king
+ * @param square - the attacked square
+ * @param enemyColor - the color of the attacking pieces
+ * @param occupied - the squares that block queens, rooks and bishops
  *
  * @return
- * true, if the king at the specified position is threatened by a queen, rook or bishop
- * false, otherwise
+ * a bitboard of the attacking pieces
  *
  * */
-bool isKingThrethenedByQueenRookBishop (SPChessGame *src, SPCoordinate coordinate){
-	int playerColor = spChessGameGetPieceColor(spChessGameGetPieceAt(src, coordinate.row, coordinate.col));
-	int enemyColor = (playerColor == SP_CHESS_GAME_WHITE) ? SP_CHESS_GAME_BLACK :  SP_CHESS_GAME_WHITE;
-
-	char piece;
-	char queenEnemy = createPiece(enemyColor, QUEEN);
-	char bishopEnemy = createPiece(enemyColor, BISHOP);
-	char rookEnemy = createPiece(enemyColor, ROOK);
-
-	//search for queen or rook in up direction
-	for (int i = 1; i <= coordinate.row; i++){
-		piece = spChessGameGetPieceAt(src, coordinate.row-i, coordinate.col);
-		if (piece == queenEnemy || piece == rookEnemy){
-			return true;
-		}
-		if (piece != SP_CHESS_GAME_EMPTY_ENTRY){
-			break;
-		}
-	}
-
-	//search for queen or rook in down direction
-	for (int i = 1; i <= 7 - coordinate.row; i++){
-		piece = spChessGameGetPieceAt(src, coordinate.row+i, coordinate.col);
-		if (piece == queenEnemy || piece == rookEnemy){
-			return true;
-		}
-		if (piece != SP_CHESS_GAME_EMPTY_ENTRY){
-			break;
-		}
-	}
-
-	//search for queen or rook in right direction
-	for (int i = 1; i <= 7 - coordinate.col; i++){
-		piece = spChessGameGetPieceAt(src, coordinate.row, coordinate.col+i);
-		if (piece == queenEnemy || piece == rookEnemy){
-			return true;
-		}
-		if (piece != SP_CHESS_GAME_EMPTY_ENTRY){
-			break;
-		}
-	}
-
-	//search for queen or rook in left direction
-	for (int i = 1; i <= coordinate.col; i++){
-		piece = spChessGameGetPieceAt(src, coordinate.row, coordinate.col-i);
-		if (piece == queenEnemy || piece == rookEnemy){
-			return true;
-		}
-		if (piece != SP_CHESS_GAME_EMPTY_ENTRY){
-			break;
-		}
-	}
-
-	//search for queen or bishop in left up direction
-	for (int i=1;i<8;i++){
-		if (!isLegalCoord((SPCoordinate){coordinate.row-i, coordinate.col-i})){
-			break;
-		}
-		piece = spChessGameGetPieceAt(src, coordinate.row-i, coordinate.col-i);
-		if (piece == queenEnemy || piece == bishopEnemy){
-			return true;
-		}
-		if (piece != SP_CHESS_GAME_EMPTY_ENTRY){
-			break;
-		}
-	}
-
-
-	//search for queen or bishop in right up direction
-	for (int i=1;i<8;i++){
-		if (!isLegalCoord((SPCoordinate){coordinate.row-i, coordinate.col+i})){
-			break;
-		}
-		piece = spChessGameGetPieceAt(src, coordinate.row-i, coordinate.col+i);
-		if (piece == queenEnemy || piece == bishopEnemy){
-			return true;
-		}
-		if (piece != SP_CHESS_GAME_EMPTY_ENTRY){
-			break;
-		}
-	}
-
-	//search for queen or bishop in left down direction
-	for (int i=1;i<8;i++){
-		if (!isLegalCoord((SPCoordinate){coordinate.row+i, coordinate.col-i})){
-			break;
-		}
-		piece = spChessGameGetPieceAt(src, coordinate.row+i, coordinate.col-i);
-		if (piece == queenEnemy || piece == bishopEnemy){
-			return true;
-		}
-		if (piece != SP_CHESS_GAME_EMPTY_ENTRY){
-			break;
-		}
-	}
-
-	//search for queen or bishop in right down direction
-	for (int i=1;i<8;i++){
-		if (!isLegalCoord((SPCoordinate){coordinate.row+i, coordinate.col+i})){
-			break;
-		}
-		piece = spChessGameGetPieceAt(src, coordinate.row+i, coordinate.col+i);
-		if (piece == queenEnemy || piece == bishopEnemy){
-			return true;
-		}
-		if (piece != SP_CHESS_GAME_EMPTY_ENTRY){
-			break;
-		}
-	}
-
-	return false;
-}
-
-/** Returns if the king at specified position is threatened by a knight
- *
- * @param src - the src game
- * @param coordinate - location of a king in the board
- *
- * @pre - the piece at specified location is a king
- *
- * @return
- * true, if the king at the specified position is threatened by a knight
- * false, otherwise
- *
- * */
-bool isKingThreathenedByKnight (SPChessGame *src, SPCoordinate coordinate){
-	int playerColor = spChessGameGetPieceColor(spChessGameGetPieceAt(src, coordinate.row, coordinate.col));
-	int enemyColor = (playerColor == SP_CHESS_GAME_WHITE) ? SP_CHESS_GAME_BLACK :  SP_CHESS_GAME_WHITE;
-
-	char piece;
-	char knightEnemy = createPiece(enemyColor, KNIGHT);
-
-	int row = coordinate.row, col = coordinate.col;
-
-	//Possible coordinates for knight
-	SPCoordinate coordinates[8] = {{.row = row-1, .col = col-2}, {.row = row+1, .col = col-2},
-			{.row = row-2, .col = col-1},{.row = row+2, .col = col-1},
-			{.row = row-2, .col = col+1}, {.row = row+2, .col = col+1} ,
-			{.row = row-1, .col = col-2}, {.row = row+1, .col = col-2}};
-
-	SPCoordinate current;
-	for (int i=0; i<8; i++){
-		current = coordinates[i];
-		if (isLegalCoord(current)){
-			piece = spChessGameGetPieceAt(src, current.row, current.col);
-			if (piece == knightEnemy){
-				return true;
-			}
-		}
-
-	}
-	return false;
-
-}
-
-/** Returns if the king at specified position is threatened by a king
- *
- * @param src - the src game
- * @param coordinate - location of a king in the board
- *
- * @pre - the piece at specified location is a king
- *
- * @return
- * true, if the king at the specified position is threatened by a king
- * false, otherwise
- *
- * */
-bool isKingThreathenedByKing (SPChessGame *src, SPCoordinate coordinate){
-	int playerColor = spChessGameGetPieceColor(spChessGameGetPieceAt(src, coordinate.row, coordinate.col));
-	int enemyColor = (playerColor == SP_CHESS_GAME_WHITE) ? SP_CHESS_GAME_BLACK :  SP_CHESS_GAME_WHITE;
-
-	char piece;
-	char kingEnemy = createPiece(enemyColor, KING);
-
-	int row = coordinate.row, col = coordinate.col;
-
-	//Possible coordinates for king
-	SPCoordinate coordinates[8] = {{.row = row-1, .col = col-1}, {.row = row, .col = col-1},{.row = row+1, .col = col-1},
-			{.row = row-1, .col = col},{.row = row+1, .col = col},
-			{.row = row-1, .col = col+1}, {.row = row, .col = col+1} ,{.row = row+1, .col = col+1}};
-
-
-	SPCoordinate current;
-	for (int i=0; i<8; i++){
-		current = coordinates[i];
-		if (isLegalCoord(current)){
-			piece = spChessGameGetPieceAt(src, current.row, current.col);
-			if (piece == kingEnemy){
-				return true;
-			}
-		}
-
-	}
-	return false;
-
-}
-
-/** Returns if the king at specified position is threatened by a pawn
- *
- * @param src - the src game
- * @param coordinate - location of a king in the board
- *
- * @pre - the piece at specified location is a king
- *
- * @return
- * true, if the king at the specified position is threatened by a pawn
- * false, otherwise
- *
- * */
-bool isKingThreathenedByPawn (SPChessGame *src, SPCoordinate coordinate){
-	int playerColor = spChessGameGetPieceColor(spChessGameGetPieceAt(src, coordinate.row, coordinate.col));
-	int enemyColor = (playerColor == SP_CHESS_GAME_WHITE) ? SP_CHESS_GAME_BLACK :  SP_CHESS_GAME_WHITE;
-
-	char piece;
-	char pawnEnemy = createPiece(enemyColor, PAWN);
-
-	int row = coordinate.row, col = coordinate.col;
-
-	//Possible coordinates for pawn
-	SPCoordinate coordinates[2];
-
-	if (enemyColor == SP_CHESS_GAME_WHITE){
-		coordinates[0] = (SPCoordinate){.row = row+1, .col = col+1};
-		coordinates[1] = (SPCoordinate){.row = row+1, .col = col-1};
-	}
-	else {
-		coordinates[0] = (SPCoordinate){.row = row-1, .col = col+1};
-		coordinates[1] = (SPCoordinate){.row = row-1, .col = col-1};
-	}
-
-	SPCoordinate current;
-	for (int i=0; i<2; i++){
-		current = coordinates[i];
-		if (isLegalCoord(current)){
-			piece = spChessGameGetPieceAt(src, current.row, current.col);
-			if (piece == pawnEnemy){
-				return true;
-			}
-		}
-
-	}
-	return false;
-
+SPBitboard getAttackers (SPChessGame *src, int square, int enemyColor, SPBitboard occupied){
+	int playerColor = (enemyColor == SP_CHESS_GAME_WHITE) ? SP_CHESS_GAME_BLACK :  SP_CHESS_GAME_WHITE;
+	const SPBitboard *enemyPieces = src->pieceBoards[enemyColor];
+	SPBitboard queens = enemyPieces[QUEEN];
+	SPBitboard res = SP_BITBOARD_EMPTY;
+
+	//queens or rooks in the rows and columns, queens or bishops in the diagonals
+	res |= slidingAttacks(rookRays, rookDirections, square, occupied) & (queens | enemyPieces[ROOK]);
+	res |= slidingAttacks(bishopRays, bishopDirections, square, occupied) & (queens | enemyPieces[BISHOP]);
+	res |= knightAttacks[square] & enemyPieces[KNIGHT];
+	res |= kingAttacks[square] & enemyPieces[KING];
+	//an enemy pawn attacks the square from the squares a pawn of the other color would attack
+	res |= pawnAttacks[playerColor][square] & enemyPieces[PAWN];
+	return res;
 }
 
 /** Returns if the king at specified position is threatened by an opponent piece
@@ -856,24 +921,11 @@ bool isKingThreathenedByPawn (SPChessGame *src, SPCoordinate coordinate){
  *
  * */
 bool isKingThrethened(SPChessGame *src, SPCoordinate coordinate){
+	int playerColor = spChessGameGetPieceColor(spChessGameGetPieceAt(src, coordinate.row, coordinate.col));
+	int enemyColor = (playerColor == SP_CHESS_GAME_WHITE) ? SP_CHESS_GAME_BLACK :  SP_CHESS_GAME_WHITE;
+	SPBitboard occupied = src->colorBoards[SP_CHESS_GAME_BLACK] | src->colorBoards[SP_CHESS_GAME_WHITE];
 
-	if (isKingThrethenedByQueenRookBishop(src, coordinate)){
-		return true;
-	}
-
-	if (isKingThreathenedByKnight(src, coordinate)){
-		return true;
-	}
-
-	if (isKingThreathenedByKing(src, coordinate)){
-		return true;
-	}
-
-	if (isKingThreathenedByPawn(src, coordinate)){
-		return true;
-	}
-
-	return false;
+	return getAttackers(src, spBitboardSquare(coordinate.row, coordinate.col), enemyColor, occupied) != SP_BITBOARD_EMPTY;
 }
 
 /** Returns whether the specified player is in Check
@@ -899,7 +951,9 @@ bool spChessGameIsPlayerInCheck(SPChessGame *src, int playerColor){
 	return isKingThrethened(src, kingPos);
 }
 
-/**Returns if the specified player has any valid moves
+/**Returns if the specified player has any valid moves.
+ * The search stops at the first valid move found, and the moves of the other pieces
+ * are tested for legality only if the previous pieces had none.
  *
  * @param src - the game src
  * @param playerColor - the color of player (SP_CHESS_GAME_BLACK \ SP_CHESS_GAME_WHITE)
@@ -910,18 +964,18 @@ bool spChessGameIsPlayerInCheck(SPChessGame *src, int playerColor){
  *
  * */
 bool spChessGameDoesPlayerHaveValidMoves(SPChessGame *src, int playerColor){
-	char piece;
-	int size;
-	SPMove moves[SP_CHESS_GAME_MAX_NUMBER_OF_MOVES];
-	for (int i=0;i<8;i++){
-		for (int j=0;j<8;j++){
-			piece = spChessGameGetPieceAt(src, i, j);
-			if (spChessGameGetPieceColor(piece) == playerColor){
-				spChessGameGetMoves(src,(SPCoordinate){.row=i,.col=j},moves,&size,false);
-				if (size != 0){
-					return true;
-				}
-			}
+	int square;
+	SPPackedMove move;
+	SPLegalityInfo info;
+	SPBitboard pieces = src->colorBoards[playerColor];
+	computeLegalityInfo(src, playerColor, &info);
+	if (shouldGenerateEvasions(src, &info)){
+		return generateEvasions(src, &info, &move, 0, 1) != 0;
+	}
+	while (pieces != SP_BITBOARD_EMPTY){
+		square = spBitboardPopFirstSquare(&pieces);
+		if (generatePieceMoves(src, spBitboardRow(square), spBitboardCol(square), &info, &move, 0, 1) != 0){
+			return true;
 		}
 	}
 	return false;
@@ -1238,27 +1292,15 @@ SP_CHESS_GAME_MESSAGE spChessGameIsValidMoveGeneric(SPChessGame *src, SPMove mov
 
 	char piece = spChessGameGetPieceAt(src, startRow, startCol);
 
-	int rowStep = 0;
-	int colStep = 0;
-
 	if (absDeltaRow == 0 && absDeltaCol == 0) { //can't stay in place
 		return SP_CHESS_GAME_INVALID_MOVE;
 	}
 
-	if (absDeltaRow != 0) {
-		rowStep = absDeltaRow / (destRow - startRow); //rowStep = +1 or -1
-	}
-	if (absDeltaCol != 0) {
-		colStep = absDeltaCol / (destCol - startCol); //colStep = +1 or -1
-	}
-
 	if (spChessGameGetPieceType(piece) != KNIGHT){
 		//can't skip other pieces
-		int m = max(absDeltaRow, absDeltaCol);
-		for (int i = 1; i < m; i++) {
-			if (spChessGameGetPieceAt(src, startRow + rowStep * i, startCol + colStep * i) != SP_CHESS_GAME_EMPTY_ENTRY) { //there is a piece in the way
-				return SP_CHESS_GAME_INVALID_MOVE;
-			}
+		SPBitboard occupied = src->colorBoards[SP_CHESS_GAME_BLACK] | src->colorBoards[SP_CHESS_GAME_WHITE];
+		if (squaresBetween[spBitboardSquare(startRow, startCol)][spBitboardSquare(destRow, destCol)] & occupied) { //there is a piece in the way
+			return SP_CHESS_GAME_INVALID_MOVE;
 		}
 	}
 
@@ -1283,9 +1325,427 @@ SP_CHESS_GAME_MESSAGE spChessGameIsValidMoveGeneric(SPChessGame *src, SPMove mov
 	return SP_CHESS_GAME_LEGAL_MOVE;
 }
 
-SP_CHESS_GAME_MESSAGE spChessGameGetMoves(SPChessGame* src, SPCoordinate coord, SPMove *moves, int *size, bool flags) {
-	int curr=0;
+/** Fills the specified legality info of the specified player in the current position:
+ * the enemy pieces which give check and the player's pieces which are pinned to the king.
+ *
+ * @param src - the game source
+ * @param color - the color of the player
+ * @param info - pointer to get the legality info
+ */
+void computeLegalityInfo (SPChessGame *src, int color, SPLegalityInfo *info){
+	int enemyColor = (color == SP_CHESS_GAME_WHITE) ? SP_CHESS_GAME_BLACK :  SP_CHESS_GAME_WHITE;
+	const SPBitboard *enemyPieces = src->pieceBoards[enemyColor];
+	SPBitboard snipers, between;
+	int king = src->kingSquares[color];
+
+	info->color = color;
+	info->kingSquare = king;
+	info->occupied = src->colorBoards[SP_CHESS_GAME_BLACK] | src->colorBoards[SP_CHESS_GAME_WHITE];
+	info->checkers = SP_BITBOARD_EMPTY;
+	info->pinned = SP_BITBOARD_EMPTY;
+	info->isExact = spBitboardCount(src->pieceBoards[color][KING]) <= 1;
+	if (king == -1 || !info->isExact){
+		return;
+	}
+	info->checkers = getAttackers(src, king, enemyColor, info->occupied);
+
+	//the enemy queens, rooks and bishops which would attack the king on an empty board
+	snipers = slidingAttacks(rookRays, rookDirections, king, SP_BITBOARD_EMPTY) & (enemyPieces[QUEEN] | enemyPieces[ROOK]);
+	snipers |= slidingAttacks(bishopRays, bishopDirections, king, SP_BITBOARD_EMPTY) & (enemyPieces[QUEEN] | enemyPieces[BISHOP]);
+	while (snipers != SP_BITBOARD_EMPTY){
+		between = squaresBetween[king][spBitboardPopFirstSquare(&snipers)] & info->occupied;
+		if (spBitboardCount(between) == 1 && (between & src->colorBoards[color])){
+			info->pinned |= between;
+		}
+	}
+}
+
+/** Returns whether the specified move of a piece of the player of the specified legality info
+ * leaves the player's king unattacked.
+ * Only a move of the king is tested against the enemy attacks,
+ * the other moves are legal if they deal with the checkers and keep the pinned pieces on their lines.
+ *
+ * @param src - the game source
+ * @param move - the move
+ * @param info - the legality info of the player, filled by computeLegalityInfo
+ *
+ * @return
+ * true - if the move doesn't leave the player in check
+ * false - otherwise
+ */
+bool isMoveLegal (SPChessGame *src, SPMove move, const SPLegalityInfo *info){
+	int king = info->kingSquare;
+	int start = spBitboardSquare(move.start.row, move.start.col);
+	int dest = spBitboardSquare(move.dest.row, move.dest.col);
+	int enemyColor = (info->color == SP_CHESS_GAME_WHITE) ? SP_CHESS_GAME_BLACK :  SP_CHESS_GAME_WHITE;
+
+	if (!info->isExact){
+		return !wouldCauseCheck(move, info->color, src);
+	}
+	if (king == -1){ //a player without a king is always in check
+		return false;
+	}
+	if (start == king){
+		//the king doesn't block the attacks along its own line
+		return getAttackers(src, dest, enemyColor, info->occupied & ~spBitboardMask(start)) == SP_BITBOARD_EMPTY;
+	}
+	if (info->checkers != SP_BITBOARD_EMPTY){
+		//a double check is evaded only by the king, a single check also by capturing or blocking the checker
+		if (spBitboardCount(info->checkers) > 1){
+			return false;
+		}
+		int checker = spBitboardFirstSquare(info->checkers);
+		if (dest != checker && !(squaresBetween[king][checker] & spBitboardMask(dest))){
+			return false;
+		}
+	}
+	if (info->pinned & spBitboardMask(start)){
+		//a pinned piece moves only towards the king or towards the pinning piece
+		return (squaresBetween[king][dest] & spBitboardMask(start)) || (squaresBetween[king][start] & spBitboardMask(dest));
+	}
+	return true;
+}
+
+/** Adds the specified move to the moves array,
+ * if it doesn't cause the player of the specified legality info to be in check.
+ * Moves that capture a king are added without checking (as in spChessGameIsValidMoveGeneric).
+ * The move is added packed, with the capture bit set if it captures a piece.
+ *
+ * @param src - the game source
+ * @param move - the move to be added
+ * @param info - the legality info of the player of the moving piece
+ * @param moves - the moves array
+ * @param size - the number of moves in the array
+ * @param capacity - the maximum number of moves in the array
+ *
+ * @return
+ * the new number of moves in the array
+ */
+int addLegalMove (SPChessGame *src, SPMove move, const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity){
+	if (size >= capacity){ //checked first, so a full array skips the legality test
+		return size;
+	}
+	char destPiece = spChessGameGetPieceAt(src, move.dest.row, move.dest.col);
+	if (spChessGameGetPieceType(destPiece) != KING && !isMoveLegal(src, move, info)){
+		return size;
+	}
+	moves[size] = spPackedMoveCreate(spBitboardSquare(move.start.row, move.start.col),
+			spBitboardSquare(move.dest.row, move.dest.col), destPiece != SP_CHESS_GAME_EMPTY_ENTRY);
+	return size+1;
+}
+
+/** Adds the legal moves from the specified square to each of the specified target squares to the moves array.
+ *
+ * @param src - the game source
+ * @param square - the square of the moving piece
+ * @param targets - the destination squares
+ * @param info - the legality info of the player of the piece
+ * @param moves - the moves array
+ * @param size - the number of moves in the array
+ * @param capacity - the maximum number of moves in the array
+ *
+ * @return
+ * the new number of moves in the array
+ */
+int addLegalMovesTo (SPChessGame *src, int square, SPBitboard targets, const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity){
+	SPMove move = {.start = {spBitboardRow(square), spBitboardCol(square)}};
+	int dest;
+	while (targets != SP_BITBOARD_EMPTY){
+		dest = spBitboardPopFirstSquare(&targets);
+		move.dest.row = spBitboardRow(dest);
+		move.dest.col = spBitboardCol(dest);
+		size = addLegalMove(src, move, info, moves, size, capacity);
+	}
+	return size;
+}
+
+/** Adds the legal moves of a knight or a king at the specified location to the moves array.
+ *
+ * @param src - the game source
+ * @param row,col - the location of the piece
+ * @param attacks - the squares the piece reaches from every square (knightAttacks \ kingAttacks)
+ * @param info - the legality info of the player of the piece
+ * @param moves - the moves array
+ * @param size - the number of moves in the array
+ * @param capacity - the maximum number of moves in the array
+ *
+ * @return
+ * the new number of moves in the array
+ */
+int generateStepMoves (SPChessGame *src, int row, int col, const SPBitboard attacks[SP_BITBOARD_N_SQUARES], const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity){
+	int square = spBitboardSquare(row, col);
+	return addLegalMovesTo(src, square, attacks[square] & ~src->colorBoards[info->color], info, moves, size, capacity);
+}
+
+/** Adds the legal moves of a rook, bishop or queen at the specified location
+ * along the specified rays to the moves array.
+ *
+ * @param src - the game source
+ * @param row,col - the location of the piece
+ * @param rays - the rays the piece slides along (rookRays \ bishopRays)
+ * @param directions - the directions of the rays (rookDirections \ bishopDirections)
+ * @param info - the legality info of the player of the piece
+ * @param moves - the moves array
+ * @param size - the number of moves in the array
+ * @param capacity - the maximum number of moves in the array
+ *
+ * @return
+ * the new number of moves in the array
+ */
+int generateSlidingMoves (SPChessGame *src, int row, int col, SPBitboard rays[4][SP_BITBOARD_N_SQUARES], const int directions[4][2], const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity){
+	int square = spBitboardSquare(row, col);
+	SPBitboard targets = slidingAttacks(rays, directions, square, info->occupied) & ~src->colorBoards[info->color];
+	return addLegalMovesTo(src, square, targets, info, moves, size, capacity);
+}
+
+/** Adds the legal moves of a pawn at the specified location to the moves array.
+ *
+ * @param src - the game source
+ * @param row,col - the location of the pawn
+ * @param info - the legality info of the player of the pawn
+ * @param moves - the moves array
+ * @param size - the number of moves in the array
+ * @param capacity - the maximum number of moves in the array
+ *
+ * @return
+ * the new number of moves in the array
+ */
+int generatePawnMoves (SPChessGame *src, int row, int col, const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity){
+	int color = info->color;
+	int enemyColor = (color == SP_CHESS_GAME_WHITE) ? SP_CHESS_GAME_BLACK :  SP_CHESS_GAME_WHITE;
+	int startRow = (color == SP_CHESS_GAME_BLACK) ? 1 : 6;
+	int square = spBitboardSquare(row, col);
+	//one or two squares forward
+	SPBitboard targets = pawnPushes[color][square] & ~info->occupied;
+	if (targets != SP_BITBOARD_EMPTY && row == startRow){
+		targets |= pawnPushes[color][spBitboardFirstSquare(targets)] & ~info->occupied;
+	}
+	//diagonal captures
+	targets |= pawnAttacks[color][square] & src->colorBoards[enemyColor];
+	return addLegalMovesTo(src, square, targets, info, moves, size, capacity);
+}
+
+/** Adds the legal moves of the piece at the specified location to the moves array.
+ *
+ * @pre the specified location contains a piece
+ * @param src - the game source
+ * @param row,col - the location of the piece
+ * @param info - the legality info of the player of the piece
+ * @param moves - the moves array
+ * @param size - the number of moves in the array
+ * @param capacity - the maximum number of moves in the array
+ *
+ * @return
+ * the new number of moves in the array
+ */
+int generatePieceMoves (SPChessGame *src, int row, int col, const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity){
+	switch (spChessGameGetPieceType(spChessGameGetPieceAt(src, row, col))){
+	case PAWN:
+		size = generatePawnMoves(src, row, col, info, moves, size, capacity);
+		break;
+	case KNIGHT:
+		size = generateStepMoves(src, row, col, knightAttacks, info, moves, size, capacity);
+		break;
+	case KING:
+		size = generateStepMoves(src, row, col, kingAttacks, info, moves, size, capacity);
+		break;
+	case BISHOP:
+		size = generateSlidingMoves(src, row, col, bishopRays, bishopDirections, info, moves, size, capacity);
+		break;
+	case ROOK:
+		size = generateSlidingMoves(src, row, col, rookRays, rookDirections, info, moves, size, capacity);
+		break;
+	case QUEEN:
+		size = generateSlidingMoves(src, row, col, rookRays, rookDirections, info, moves, size, capacity);
+		size = generateSlidingMoves(src, row, col, bishopRays, bishopDirections, info, moves, size, capacity);
+		break;
+	case BLANK:
+		break;
+	}
+	return size;
+}
+
+/** Returns whether the moves of the player of the specified legality info should be generated
+ * by generateEvasions, that is if the player is in check.
+ * A position where the player can capture an enemy king (which a loaded game may have)
+ * is left to the generation of every piece, since capturing a king is always allowed.
+ *
+ * @param src - the game source
+ * @param info - the legality info of the player
+ *
+ * @return
+ * true - if generateEvasions generates all the legal moves of the player
+ * false - otherwise
+ */
+bool shouldGenerateEvasions (SPChessGame *src, const SPLegalityInfo *info){
+	if (!info->isExact || info->kingSquare == -1 || info->checkers == SP_BITBOARD_EMPTY){
+		return false;
+	}
+	int enemyColor = (info->color == SP_CHESS_GAME_WHITE) ? SP_CHESS_GAME_BLACK :  SP_CHESS_GAME_WHITE;
+	SPBitboard enemyKings = src->pieceBoards[enemyColor][KING];
+	while (enemyKings != SP_BITBOARD_EMPTY){
+		if (getAttackers(src, spBitboardPopFirstSquare(&enemyKings), info->color, info->occupied) != SP_BITBOARD_EMPTY){
+			return false;
+		}
+	}
+	return true;
+}
+
+/** Adds the moves of the unpinned pawns of the player of the specified legality info
+ * which move forward to the specified empty square to the moves array.
+ *
+ * @param src - the game source
+ * @param square - the destination square
+ * @param info - the legality info of the player
+ * @param moves - the moves array
+ * @param size - the number of moves in the array
+ * @param capacity - the maximum number of moves in the array
+ *
+ * @return
+ * the new number of moves in the array
+ */
+int generatePawnBlocks (SPChessGame *src, int square, const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity){
+	int color = info->color;
+	int enemyColor = (color == SP_CHESS_GAME_WHITE) ? SP_CHESS_GAME_BLACK :  SP_CHESS_GAME_WHITE;
+	int startRow = (color == SP_CHESS_GAME_BLACK) ? 1 : 6;
+	SPBitboard pawns = src->pieceBoards[color][PAWN] & ~info->pinned;
+	//a pawn of the player moves forward from the square in front of the destination as seen by the enemy
+	SPBitboard start = pawnPushes[enemyColor][square];
+	if (start == SP_BITBOARD_EMPTY){
+		return size;
+	}
+	if (pawns & start){ //one square forward
+		return addLegalMovesTo(src, spBitboardFirstSquare(start), spBitboardMask(square), info, moves, size, capacity);
+	}
+	if (start & info->occupied){
+		return size;
+	}
+	start = pawnPushes[enemyColor][spBitboardFirstSquare(start)];
+	if ((pawns & start) && spBitboardRow(spBitboardFirstSquare(start)) == startRow){ //two squares forward
+		size = addLegalMovesTo(src, spBitboardFirstSquare(start), spBitboardMask(square), info, moves, size, capacity);
+	}
+	return size;
+}
+
+/** Adds the legal moves of the player of the specified legality info, who is in check, to the moves array.
+ * Only the moves of the king, the captures of the checking piece and the moves to the squares
+ * between it and the king are generated.
+ *
+ * @pre shouldGenerateEvasions(src, info)
+ * @param src - the game source
+ * @param info - the legality info of the player
+ * @param moves - the moves array
+ * @param size - the number of moves in the array
+ * @param capacity - the maximum number of moves in the array
+ *
+ * @return
+ * the new number of moves in the array
+ */
+int generateEvasions (SPChessGame *src, const SPLegalityInfo *info, SPPackedMove *moves, int size, int capacity){
+	int king = info->kingSquare;
+	int checker, target;
+	SPBitboard targets, movers;
+	//a pinned piece can't leave its line, which meets the line of the check only at the king
+	SPBitboard pieces = src->colorBoards[info->color] & ~src->pieceBoards[info->color][KING] & ~info->pinned;
+	SPMove move;
+
+	size = generateStepMoves(src, spBitboardRow(king), spBitboardCol(king), kingAttacks, info, moves, size, capacity);
+	if (spBitboardCount(info->checkers) > 1){ //only the king can evade a double check
+		return size;
+	}
+	checker = spBitboardFirstSquare(info->checkers);
+	targets = info->checkers | squaresBetween[king][checker];
+	while (targets != SP_BITBOARD_EMPTY){
+		target = spBitboardPopFirstSquare(&targets);
+		move.dest.row = spBitboardRow(target);
+		move.dest.col = spBitboardCol(target);
+		movers = getAttackers(src, target, info->color, info->occupied) & pieces;
+		if (target != checker){ //a pawn moves to an empty square only forward
+			movers &= ~src->pieceBoards[info->color][PAWN];
+			size = generatePawnBlocks(src, target, info, moves, size, capacity);
+		}
+		while (movers != SP_BITBOARD_EMPTY){
+			int square = spBitboardPopFirstSquare(&movers);
+			move.start.row = spBitboardRow(square);
+			move.start.col = spBitboardCol(square);
+			size = addLegalMove(src, move, info, moves, size, capacity);
+		}
+	}
+	return size;
+}
+
+/** Sorts the specified moves by their destination:
+ * column by column from left to right, and inside each column from the bottom row to the top row.
+ *
+ * @param moves - the moves array
+ * @param size - the number of moves in the array
+ */
+void sortMovesByBoardOrder (SPMove *moves, int size){
+	SPMove move;
+	int key, j;
+	for (int i=1; i<size; i++){
+		move = moves[i];
+		key = move.dest.col*SP_CHESS_GAME_N_ROWS - move.dest.row;
+		for (j=i-1; j>=0 && moves[j].dest.col*SP_CHESS_GAME_N_ROWS - moves[j].dest.row > key; j--){
+			moves[j+1] = moves[j];
+		}
+		moves[j+1] = move;
+	}
+}
 
+/** All the legal moves of the current player are inserted to the given array, packed for the search.
+ * The capture bit of every move is set if it captures a piece.
+ *
+ * @pre @moves contains space for SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES moves
+ *
+ * @param src - the source game
+ * @param *moves - pointer to the resulted array
+ * @param *size - pointer to get the size of moves array
+ *
+ * @return
+ * SP_CHESS_GAME_INVALID_ARGUMENT - if src == NULL
+ * SP_CHESS_GAME_SUCCESS - otherwise
+ */
+SP_CHESS_GAME_MESSAGE spChessGameGenerateAllMoves(SPChessGame* src, SPPackedMove *moves, int *size){
+	if (src == NULL){
+		return SP_CHESS_GAME_INVALID_ARGUMENT;
+	}
+	int curr = 0, square;
+	SPLegalityInfo info;
+	SPBitboard pieces = src->colorBoards[src->currentPlayer];
+	computeLegalityInfo(src, src->currentPlayer, &info);
+	if (shouldGenerateEvasions(src, &info)){
+		*size = generateEvasions(src, &info, moves, 0, SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES);
+		return SP_CHESS_GAME_SUCCESS;
+	}
+	while (pieces != SP_BITBOARD_EMPTY){
+		square = spBitboardPopFirstSquare(&pieces);
+		curr = generatePieceMoves(src, spBitboardRow(square), spBitboardCol(square), &info, moves, curr, SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES);
+	}
+	*size = curr;
+	return SP_CHESS_GAME_SUCCESS;
+}
+
+/** All the legal moves of the piece at the specified location are inserted to the given array,
+ * ordered column by column from left to right, and inside each column from the bottom row to the top row.
+ * if flags==true, then for every move in the array the fields isThreatened and doesCapturePiece
+ * are set to true\false according to whether the move is threatened by an enemy piece
+ * and whether it captures a piece.
+ *
+ * @pre @moves contains enough space to contain all the available moves
+ *
+ * @param src - the source game
+ * @param coord - the piece location
+ * @param *moves - pointer to the resulted array
+ * @param *size - pointer to get the size of moves array
+ * @param flags - whether to check if the move captures piece and if it is threatened by the enemy
+ *
+ * @return
+ * SP_CHESS_GAME_INVALID_ARGUMENT - if the specified location is not a valid coordinate in the board
+ * SP_CHESS_GAME_POSITION_NOT_CONTAIN_PIECE - if the specified location doesn't contain a piece
+ * SP_CHESS_GAME_SUCCESS - otherwise
+ */
+SP_CHESS_GAME_MESSAGE spChessGameGetMoves(SPChessGame* src, SPCoordinate coord, SPMove *moves, int *size, bool flags) {
 	if (!isLegalCoord(coord)){
 		return SP_CHESS_GAME_INVALID_ARGUMENT;
 	}
@@ -1294,27 +1754,31 @@ SP_CHESS_GAME_MESSAGE spChessGameGetMoves(SPChessGame* src, SPCoordinate coord,
 		return SP_CHESS_GAME_POSITION_NOT_CONTAIN_PIECE;
 	}
 	char capturedPiece;
-	SPMove move;
-	move.start = coord;
-
-
-	for (int j=0;j<8;j++){
-		for (int i=7;i>=0;i--){
-			move.dest.row = i; move.dest.col = j;
-			if (moveStatus(src,move)==SP_CHESS_GAME_LEGAL_MOVE){
-				if (flags){
-					//check if the move captures enemy piece
-					move.doesCapturePiece = doesMoveCapturePiece(src, move);
-					//check if the move is threatened by the opponent
-					capturedPiece = spChessGameGetPieceAt(src, i, j);
-					applyMove(src, move);
-					move.isThreatened = canPlayerMoveTo(src, move.dest, 1-spChessGameGetPieceColor(piece));
-					//undo move
-					undoMove(src, move, capturedPiece);
-				}
-				//add move to the array
-				moves[curr++] = move;
-			}
+	SPLegalityInfo info;
+	SPPackedMove packedMoves[SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES];
+	int curr = 0, nPacked;
+	computeLegalityInfo(src, spChessGameGetPieceColor(piece), &info);
+	if (shouldGenerateEvasions(src, &info)){ //keep the evasions of the piece
+		nPacked = generateEvasions(src, &info, packedMoves, 0, SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES);
+	}
+	else {
+		nPacked = generatePieceMoves(src, coord.row, coord.col, &info, packedMoves, 0, SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES);
+	}
+	for (int k=0; k<nPacked; k++){
+		if (spPackedMoveStart(packedMoves[k]) == spBitboardSquare(coord.row, coord.col)){
+			moves[curr++] = spChessGameUnpackMove(packedMoves[k]);
+		}
+	}
+	sortMovesByBoardOrder(moves, curr);
+
+	if (flags){
+		for (int k=0; k<curr; k++){
+			//check if the move is threatened by the opponent
+			capturedPiece = spChessGameGetPieceAt(src, moves[k].dest.row, moves[k].dest.col);
+			applyMove(src, moves[k]);
+			moves[k].isThreatened = canPlayerMoveTo(src, moves[k].dest, 1-spChessGameGetPieceColor(piece));
+			//undo move
+			undoMove(src, moves[k], capturedPiece);
 		}
 	}
 	*size = curr;
@@ -1334,13 +1798,45 @@ char spChessGameGetPieceAt (SPChessGame *src, int row, int col){
 	return src->gameBoard[row][col];
 }
 
-/** Sets the specified position to contain the specified piece
+/** Sets the specified position to contain the specified piece,
+ * and updates the bitboards, the Zobrist key, the score and the king squares of the game accordingly
  *
+ * @pre src!=NULL, row,col are legal
  * @param src - the game source
- * @param piece - the piece to be set on the board
+ * @param piece - the piece to be set on the board (SP_CHESS_GAME_EMPTY_ENTRY to clear the position)
  * @param row,col - the location to set the piece on the board
  */
 void setPieceAt (SPChessGame *src, char piece, int row, int col){
+	SPBitboard mask = spBitboardMask(spBitboardSquare(row, col));
+	char prevPiece = src->gameBoard[row][col];
+	SPPieceType type;
+	int color;
+	//remove the previous piece from the bitboards
+	type = spChessGameGetPieceType(prevPiece);
+	if (type != BLANK){
+		color = spChessGameGetPieceColor(prevPiece);
+		src->pieceBoards[color][type] &= ~mask;
+		src->colorBoards[color] &= ~mask;
+		src->hashKey ^= zobristPieceKeys[color][type][spBitboardSquare(row, col)];
+		src->score -= getPieceSquareScore(type, color, spBitboardSquare(row, col));
+		if (type == KING){
+			//a loaded board may have another king of the same color
+			src->kingSquares[color] = (src->pieceBoards[color][KING] != SP_BITBOARD_EMPTY) ?
+					spBitboardFirstSquare(src->pieceBoards[color][KING]) : -1;
+		}
+	}
+	//add the new piece to the bitboards
+	type = spChessGameGetPieceType(piece);
+	if (type != BLANK){
+		color = spChessGameGetPieceColor(piece);
+		src->pieceBoards[color][type] |= mask;
+		src->colorBoards[color] |= mask;
+		src->hashKey ^= zobristPieceKeys[color][type][spBitboardSquare(row, col)];
+		src->score += getPieceSquareScore(type, color, spBitboardSquare(row, col));
+		if (type == KING){
+			src->kingSquares[color] = spBitboardFirstSquare(src->pieceBoards[color][KING]);
+		}
+	}
 	src->gameBoard[row][col] = piece;
 }
 
@@ -1429,16 +1925,95 @@ int spChessGameGetCurrentPlayer(SPChessGame* src) {
  */
 void spChessGameChangePlayer (SPChessGame* src){
 	src->currentPlayer = 1-src->currentPlayer;
+	src->hashKey ^= zobristBlackToMoveKey;
 }
 
-/** Returns a score for the specified piece
+/** Returns the Zobrist key of the current position of the game.
+ * The key identifies the pieces on the board and the player to move,
+ * and is updated in O(1) whenever a piece is set or the current player changes.
  *
- * @param piece
- * @return a score for the specified piece
+ * @param src - the game source
+ * @return
+ * the Zobrist key of the position
  */
-int getPieceScore(char piece){
-	SPPieceType pType = spChessGameGetPieceType(piece);
-	switch (pType){
+uint64_t spChessGameGetHashKey (SPChessGame* src){
+	return src->hashKey;
+}
+
+/** Returns the score of the current position of the game: the same score as the default scoreFunc
+ * (black's material and piece-square scores minus white's), which is updated in O(1) whenever a piece is set.
+ * scoreFunc recomputes it from the bitboards, and is kept as the reference.
+ *
+ * @param src - the game source
+ * @return
+ * the score of the position
+ */
+int spChessGameGetScore (SPChessGame* src){
+	return src->score;
+}
+
+/** Packs the specified move
+ *
+ * @pre the start and destination of the move are on the board
+ * @param move - the move
+ * @return
+ * the packed move, with the capture bit set if move.doesCapturePiece is set
+ */
+SPPackedMove spChessGamePackMove (SPMove move){
+	return spPackedMoveCreate(spBitboardSquare(move.start.row, move.start.col),
+			spBitboardSquare(move.dest.row, move.dest.col), move.doesCapturePiece);
+}
+
+/** Unpacks the specified move
+ *
+ * @param move - the packed move
+ * @return
+ * the move, with doesCapturePiece set by the capture bit and isThreatened set to false.
+ * SP_PACKED_MOVE_NONE is unpacked to {{-1,-1},{-1,-1},0,0}
+ */
+SPMove spChessGameUnpackMove (SPPackedMove move){
+	SPMove res = {{-1,-1},{-1,-1},0,0};
+	if (move == SP_PACKED_MOVE_NONE){
+		return res;
+	}
+	res.start.row = spBitboardRow(spPackedMoveStart(move));
+	res.start.col = spBitboardCol(spPackedMoveStart(move));
+	res.dest.row = spBitboardRow(spPackedMoveDest(move));
+	res.dest.col = spBitboardCol(spPackedMoveDest(move));
+	res.doesCapturePiece = spPackedMoveIsCapture(move);
+	return res;
+}
+
+/** Recomputes the Zobrist key of the specified game from scratch.
+ * Should be called after the board or the current player were set
+ * without going through setPieceAt or spChessGameChangePlayer.
+ *
+ * @param src - the game source
+ */
+void spChessGameComputeHashKey (SPChessGame* src){
+	uint64_t key = 0;
+	SPBitboard pieces;
+	for (int color=0; color<2; color++){
+		for (int type=0; type<SP_CHESS_GAME_N_PIECE_TYPES; type++){
+			pieces = src->pieceBoards[color][type];
+			while (pieces != SP_BITBOARD_EMPTY){
+				key ^= zobristPieceKeys[color][type][spBitboardPopFirstSquare(&pieces)];
+			}
+		}
+	}
+	if (src->currentPlayer == SP_CHESS_GAME_BLACK){
+		key ^= zobristBlackToMoveKey;
+	}
+	src->hashKey = key;
+}
+
+/** Returns a score for a piece of the specified type
+ *
+ * @param type - the piece type
+ * @return a score for a piece of the specified type
+ */
+int spChessGameGetPieceTypeScore(SPPieceType type){
+	switch (type){
 	case PAWN:
 		return 1;
 	case KNIGHT:
@@ -1457,10 +2032,38 @@ int getPieceScore(char piece){
 	return 0;
 }
 
+/** Returns a score for the specified piece
+ *
+ * @param piece
+ * @return a score for the specified piece
+ */
+int getPieceScore(char piece){
+	return spChessGameGetPieceTypeScore(spChessGameGetPieceType(piece));
+}
+
+/** Returns the part of the score of a game state given by a piece of the specified type and color
+ *  on the specified square: its material score in SP_CHESS_GAME_SCORE_UNIT units plus its piece-square score,
+ *  positive for a black piece and negative for a white piece
+ *
+ *  @param type - the piece type (not BLANK)
+ *  @param color - the color of the piece
+ *  @param square - the square of the piece
+ *  @return
+ *  the score of the piece
+ */
+int getPieceSquareScore(SPPieceType type, int color, int square){
+	if (color == SP_CHESS_GAME_BLACK){
+		//mirror the row, the column stays the same
+		return spChessGameGetPieceTypeScore(type)*SP_CHESS_GAME_SCORE_UNIT +
+				pieceSquareScores[type][square ^ (SP_BITBOARD_N_SQUARES - SP_BITBOARD_N_COLUMNS)];
+	}
+	return -(spChessGameGetPieceTypeScore(type)*SP_CHESS_GAME_SCORE_UNIT + pieceSquareScores[type][square]);
+}
+
 /** Computes the score of a specified game state
  *  the black player's pieces has positive scores
  *  and the white player's pieces has negative scores
- * 	The score is calculated according to the pieces on the board
+ * 	The score is calculated according to the pieces on the board and their squares
  *
  * 	@param src - the source game
  *
@@ -1469,16 +2072,14 @@ int getPieceScore(char piece){
  */
 int scoreFunc (void* src){
 	SPChessGame *game = (SPChessGame*)src;
-	int score = 0, pieceScore;
-
-	for (int i=0;i<8;i++){
-		for (int j=0;j<8;j++){
-			pieceScore = getPieceScore(spChessGameGetPieceAt(game,i,j));
-			if (spChessGameGetPieceColor(spChessGameGetPieceAt(game,i,j))==SP_CHESS_GAME_BLACK){
-				score+=pieceScore;
-			}
-			else {
-				score-=pieceScore;
+	int score = 0;
+	SPBitboard pieces;
+
+	for (int color=0;color<2;color++){
+		for (int type=0;type<SP_CHESS_GAME_N_PIECE_TYPES;type++){
+			pieces = game->pieceBoards[color][type];
+			while (pieces != SP_BITBOARD_EMPTY){
+				score += getPieceSquareScore(type, color, spBitboardPopFirstSquare(&pieces));
 			}
 		}
 	}
@@ -1511,4 +2112,5 @@ void spChessGameRestartGame (SPChessGame* src){
 	src->game_mode = mode;
 	src->userColor = userColor;
 	src->isSaved = 0;
+	spChessGameComputeHashKey(src);
 }
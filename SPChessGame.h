@@ -1,8 +1,11 @@
 #ifndef SPCHESSGAME_H_
 #define SPCHESSGAME_H_
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include "SPArrayList.h"
+#include "SPBitboard.h"
+#include "SPPackedMove.h"
 
 /**
  * SPCHESSGame Summary:
@@ -16,8 +19,15 @@
  * spChessGameSetMove          - Sets a move on a game board
  * spChessGameIsValidMove      - Checks if a move is valid
  * spChessGameUndoPrevMove     - Undoes previous move made by the last player
+ * spChessGameMakeSearchMove   - Sets a move without recording it in the history
+ * spChessGameUnmakeSearchMove - Takes back a move made by spChessGameMakeSearchMove
  * spChessGamePrintBoard       - Prints the current board
  * spChessGameGetCurrentPlayer - Returns the current player
+ * spChessGameGenerateAllMoves - Returns all the legal moves of the current player
+ * spChessGameGetHashKey       - Returns the Zobrist key of the current position
+ * spChessGameGetScore         - Returns the score of the current position
+ * spChessGamePackMove         - Packs a move into an SPPackedMove
+ * spChessGameUnpackMove       - Unpacks an SPPackedMove into a move
  *
  */
 
@@ -26,9 +36,12 @@
 #define SP_CHESS_GAME_N_COLUMNS 8
 #define SP_CHESS_GAME_EMPTY_ENTRY '_'
 #define SP_CHESS_GAME_MAX_NUMBER_OF_MOVES 64
+#define SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES 256
+#define SP_CHESS_GAME_N_PIECE_TYPES 6
 
-#define SP_CHESS_GAME_MAX_SCORE 1000
-#define SP_CHESS_GAME_MIN_SCORE -1000
+#define SP_CHESS_GAME_SCORE_UNIT 100 //the score of a pawn: piece-square scores are in hundredths of a pawn
+#define SP_CHESS_GAME_MAX_SCORE (1000*SP_CHESS_GAME_SCORE_UNIT)
+#define SP_CHESS_GAME_MIN_SCORE (-1000*SP_CHESS_GAME_SCORE_UNIT)
 #define SP_CHESS_GAME_DRAW_SCORE 0
 
 #define SP_CHESS_GAME_BLACK 0
@@ -52,6 +65,28 @@ typedef struct sp_move_t {
 	bool isThreatened, doesCapturePiece;
 } SPMove;
 
+/**
+ * Type used to record the state a move destroys,
+ * so that a move made by spChessGameMakeSearchMove can be taken back
+ */
+typedef struct sp_undo_info_t {
+	SPPackedMove move;
+	char capturedPiece;
+} SPUndoInfo;
+
+/**
+ * Type used by the move generation to record, once per position, what makes the moves of a player illegal,
+ * so that only the moves of the king have to be tested against the enemy attacks
+ */
+typedef struct sp_legality_info_t {
+	int color; //the color of the player
+	int kingSquare; //the square of the player's king, -1 if there's none
+	SPBitboard occupied; //the squares of all the pieces on the board
+	SPBitboard checkers; //the enemy pieces which attack the king
+	SPBitboard pinned; //the player's pieces which are the only piece between the king and an enemy queen, rook or bishop
+	bool isExact; //false if the player has more than one king, then every move is tested by making it
+} SPLegalityInfo;
+
 /**
  * Represents type of a piece in the game
  */
@@ -66,10 +101,19 @@ typedef enum SPPieceType {
 } SPPieceType;
 
 /**
- * Type used to represent a game
+ * Type used to represent a game.
+ * The position is kept in pieceBoards and colorBoards, which are updated by setPieceAt.
+ * colorBoards serve as the piece lists of the players: move generation and scoring
+ * iterate over their set bits, so their cost depends on the number of pieces left.
+ * gameBoard mirrors them square by square for printing, saving and single square lookups.
  */
 typedef struct sp_chess_game_t {
+	SPBitboard pieceBoards[2][SP_CHESS_GAME_N_PIECE_TYPES]; //[color][SPPieceType] - squares of each kind of piece
+	SPBitboard colorBoards[2]; //[color] - squares of all the pieces of each player
 	char gameBoard[SP_CHESS_GAME_N_ROWS][SP_CHESS_GAME_N_COLUMNS];
+	uint64_t hashKey; //Zobrist key of the position, updated by setPieceAt and spChessGameChangePlayer
+	int score; //black's material and piece-square scores minus white's, updated by setPieceAt
+	int kingSquares[2]; //[color] - square of each player's king, -1 if there's none, updated by setPieceAt
 	int currentPlayer ;
 	int game_mode ;
 	int difficulty ;
@@ -197,6 +241,28 @@ SP_CHESS_GAME_MESSAGE spChessGameSetMove(SPChessGame* src, SPMove move);
  */
 SP_CHESS_GAME_MESSAGE spChessGameUndoPrevMove(SPChessGame* src) ;
 
+/**
+ * Sets the specified move and changes the current player, without adding the move
+ * to the moves history. The state needed to take the move back is stored in undo.
+ * Intended for searching, where every move is taken back by spChessGameUnmakeSearchMove.
+ *
+ * @pre the move is one of the moves returned by spChessGameGenerateAllMoves
+ * @param src - The target game
+ * @param move - The move to be applied
+ * @param undo - pointer to get the state needed to take the move back
+ */
+void spChessGameMakeSearchMove(SPChessGame* src, SPPackedMove move, SPUndoInfo *undo);
+
+/**
+ * Takes back a move that has been made by spChessGameMakeSearchMove
+ * and changes the current player back.
+ *
+ * @pre undo was filled by the last spChessGameMakeSearchMove on src that wasn't taken back
+ * @param src - The target game
+ * @param undo - the state recorded when the move was made
+ */
+void spChessGameUnmakeSearchMove(SPChessGame* src, const SPUndoInfo *undo);
+
 /** Undoes the specified move on the src game:
  * the piece at location move.dest is being moved to location move.start
  * and capturedPiece is being set at location move.dest
@@ -207,6 +273,16 @@ SP_CHESS_GAME_MESSAGE spChessGameUndoPrevMove(SPChessGame* src) ;
  */
 void undoMove (SPChessGame* src, SPMove move, char capturedPiece);
 
+/** Sets the specified position to contain the specified piece,
+ * and updates the bitboards of the game accordingly
+ *
+ * @pre src!=NULL, row,col are legal
+ * @param src - the game source
+ * @param piece - the piece to be set on the board (SP_CHESS_GAME_EMPTY_ENTRY to clear the position)
+ * @param row,col - the location to set the piece on the board
+ */
+void setPieceAt (SPChessGame *src, char piece, int row, int col);
+
 /** Returns whether the specified player is in Check
  * (if his king is threatened by an enemy piece)
  *
@@ -238,7 +314,8 @@ bool spChessGameIsPlayerInCheck(SPChessGame *src, int playerColor);
  */
 int spChessGameGetState(SPChessGame *src);
 
-/** All the legal moves of the piece at the specified location are inserted to the given array.
+/** All the legal moves of the piece at the specified location are inserted to the given array,
+ * ordered column by column from left to right, and inside each column from the bottom row to the top row.
  * if flags==true, then for every move in the array the fields isThreatened and doesCapturePiece
  * are set to true\false according to whether the move is threatened by an enemy piece
  * and whether it captures a piece.
@@ -258,6 +335,23 @@ int spChessGameGetState(SPChessGame *src);
  */
 SP_CHESS_GAME_MESSAGE spChessGameGetMoves(SPChessGame* src, SPCoordinate coord, SPMove *moves, int *size, bool flags) ;
 
+/** All the legal moves of the current player are inserted to the given array, packed for the search.
+ * The moves are generated directly from the squares each piece can reach,
+ * without probing every destination on the board.
+ * The capture bit of every move is set if it captures a piece.
+ *
+ * @pre @moves contains space for SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES moves
+ *
+ * @param src - the source game
+ * @param *moves - pointer to the resulted array
+ * @param *size - pointer to get the size of moves array
+ *
+ * @return
+ * SP_CHESS_GAME_INVALID_ARGUMENT - if src == NULL
+ * SP_CHESS_GAME_SUCCESS - otherwise
+ */
+SP_CHESS_GAME_MESSAGE spChessGameGenerateAllMoves(SPChessGame* src, SPPackedMove *moves, int *size);
+
 /** Returns the piece at the specified location on the board
  *
  * @pre src!=NULL, row,col are legal
@@ -307,6 +401,59 @@ void spChessGameChangePlayer (SPChessGame* src);
  */
 SPPieceType spChessGameGetPieceType (char piece);
 
+/** Returns a score for a piece of the specified type
+ *
+ * @param type - the piece type
+ * @return a score for a piece of the specified type
+ */
+int spChessGameGetPieceTypeScore(SPPieceType type);
+
+/** Returns the Zobrist key of the current position of the game.
+ * The key identifies the pieces on the board and the player to move,
+ * and is updated in O(1) whenever a piece is set or the current player changes.
+ *
+ * @param src - the game source
+ * @return
+ * the Zobrist key of the position
+ */
+uint64_t spChessGameGetHashKey (SPChessGame* src);
+
+/** Returns the score of the current position of the game: the same score as the default scoreFunc
+ * (black's material and piece-square scores minus white's), which is updated in O(1) whenever a piece is set.
+ * scoreFunc recomputes it from the bitboards, and is kept as the reference.
+ *
+ * @param src - the game source
+ * @return
+ * the score of the position
+ */
+int spChessGameGetScore (SPChessGame* src);
+
+/** Packs the specified move
+ *
+ * @pre the start and destination of the move are on the board
+ * @param move - the move
+ * @return
+ * the packed move, with the capture bit set if move.doesCapturePiece is set
+ */
+SPPackedMove spChessGamePackMove (SPMove move);
+
+/** Unpacks the specified move
+ *
+ * @param move - the packed move
+ * @return
+ * the move, with doesCapturePiece set by the capture bit and isThreatened set to false.
+ * SP_PACKED_MOVE_NONE is unpacked to {{-1,-1},{-1,-1},0,0}
+ */
+SPMove spChessGameUnpackMove (SPPackedMove move);
+
+/** Recomputes the Zobrist key of the specified game from scratch.
+ * Should be called after the board or the current player were set
+ * without going through setPieceAt or spChessGameChangePlayer.
+ *
+ * @param src - the game source
+ */
+void spChessGameComputeHashKey (SPChessGame* src);
+
 /** Restarts the game with the current game settings
  *
  * @param src - the game src
@@ -333,7 +480,9 @@ int spChessGameParseRow (char row);
  */
 int spChessGameParseColumn (char col);
 
-/**Returns if the specified player has any valid moves
+/**Returns if the specified player has any valid moves.
+ * The search stops at the first valid move found, and the moves of the other pieces
+ * are tested for legality only if the previous pieces had none.
  *
  * @param src - the game src
  * @param playerColor - the color of player (SP_CHESS_GAME_BLACK \ SP_CHESS_GAME_WHITE)
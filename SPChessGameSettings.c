@@ -260,7 +260,7 @@ void setBoardRow (SPChessGame *src, char *line){
 	int col = 0;
 	for (int k=0; k<len; k++){
 		if (line[k]==SP_CHESS_GAME_EMPTY_ENTRY || (line[k]>='a'&&line[k]<='z') || (line[k]>='A'&&line[k]<='Z')){
-			src->gameBoard[row][col] = line[k];
+			setPieceAt(src, line[k], row, col);
 			col++;
 		}
 	}
@@ -349,6 +349,7 @@ SP_CHESS_GAME_MESSAGE spChessGameSettingsLoad (SPChessGame* src, char *fileName)
 	fclose(f);
 
 	spChessGameCleanHistory(src); //delete history
+	spChessGameComputeHashKey(src); //the board and current player were set directly
 
 	return SP_CHESS_GAME_SUCCESS;
 }
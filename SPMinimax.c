@@ -1,5 +1,151 @@
+#define _POSIX_C_SOURCE 200112L //for sysconf and nanosleep
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include "SPMinimaxNode.h"
+#include "SPMinimax.h"
+
+static SPTransTable *transTable = NULL; //the table shared by all the searches
+static unsigned int hashSizeMB = SP_MINIMAX_DEFAULT_HASH_SIZE_MB; //the size of transTable
+static unsigned int nSearchThreads = 1; //the number of threads of every search
+static SP_MINIMAX_PARALLEL_MODE parallelMode = SP_MINIMAX_LAZY_SMP; //the way the threads share the work
+static SPMinimaxPonder ponder; //the search on the user's time
+static SPMinimaxStats lastStats; //the statistics of the last search
+
+/**
+ * Returns the transposition table of the searches,
+ * and allocates it if it hasn't been allocated yet.
+ *
+ * @return
+ * NULL if the searches run without a table or the allocation has failed,
+ * otherwise the table
+ */
+SPTransTable* getTransTable(){
+	if (transTable == NULL && hashSizeMB > 0){
+		transTable = spTransTableCreate(hashSizeMB);
+	}
+	return transTable;
+}
+
+/**
+ * Searches the current position to the specified depth with the specified number of threads,
+ * in the specified parallel mode. The searches of spMinimaxSuggestMove and of the pondering are made by it,
+ * so the pondering finds the same move as a search of the position would.
+ *
+ * @param currentGame - The current game state
+ * @param maxDepth - The maximum depth of the miniMax algorithm
+ * @param nThreads - The number of threads
+ * @param mode - The way the threads share the work
+ * @param table - The transposition table, or NULL to search without it
+ * @param handle - The handle of the search
+ * @return
+ * the best move for the current player, as returned by the search
+ */
+SPMove searchToDepth(SPChessGame* currentGame, unsigned int maxDepth, unsigned int nThreads,
+		SP_MINIMAX_PARALLEL_MODE mode, SPTransTable *table, SPMinimaxHandle *handle){
+	if (nThreads > 1 && mode == SP_MINIMAX_ROOT_SPLIT){
+		return spMiniMaxRootSplit(currentGame, maxDepth, nThreads, handle);
+	}
+	if (nThreads > 1 && mode == SP_MINIMAX_YBWC){
+		return spMiniMaxYBWC(currentGame, maxDepth, nThreads, table, handle);
+	}
+	if (nThreads > 1){
+		return spMiniMaxIterative(currentGame, maxDepth, SP_MINIMAX_NO_TIME_LIMIT, nThreads, table, handle, NULL);
+	}
+	return spMiniMax(currentGame, maxDepth, table, handle);
+}
+
+/**
+ * The start routine of the pondering thread
+ *
+ * @param arg - the pondering state (SPMinimaxPonder*)
+ * @return NULL
+ */
+void* ponderThreadMain(void *arg){
+	SPMinimaxPonder *state = (SPMinimaxPonder*)arg;
+	state->bestMove = searchToDepth(state->game, state->depth, state->nThreads,
+			(SP_MINIMAX_PARALLEL_MODE)state->parallelMode, state->transTable, &state->handle);
+	__atomic_store_n(&state->isDone, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+/**
+ * Adds the statistics of a search to the statistics of another search
+ * which has been completed by it.
+ *
+ * @param dest - the statistics to be updated
+ * @param src - the statistics of the search
+ */
+void mergeStats(SPMinimaxStats *dest, const SPMinimaxStats *src){
+	dest->nodes += src->nodes;
+	dest->leafEvals += src->leafEvals;
+	dest->interiorNodes += src->interiorNodes;
+	dest->movesSearched += src->movesSearched;
+	dest->betaCutoffs += src->betaCutoffs;
+	dest->firstMoveCutoffs += src->firstMoveCutoffs;
+	dest->ttProbes += src->ttProbes;
+	dest->ttHits += src->ttHits;
+	dest->depth = (dest->depth > src->depth) ? dest->depth : src->depth;
+	dest->maxPly = (dest->maxPly > src->maxPly) ? dest->maxPly : src->maxPly;
+}
+
+/**
+ * Ends the pondering, if there's one. If the specified position is the pondered position,
+ * and the pondering searches it to maxDepth, the function waits for the pondering to complete
+ * and returns its result. Otherwise the pondering is stopped.
+ * While waiting, the pondering is stopped as soon as the specified handle is stopped.
+ *
+ * @param currentGame - The current game state
+ * @param maxDepth - The depth the current position has to be searched to
+ * @param handle - The handle of the current search, its statistics are updated on a hit
+ * @param move - pointer to get the result of the pondering
+ * @return
+ * true - if the result of the pondering is set to move
+ * false - otherwise
+ */
+bool finishPondering(SPChessGame* currentGame, unsigned int maxDepth, SPMinimaxHandle *handle, SPMove *move){
+	struct timespec pollTime = {0, SP_MINIMAX_PONDER_POLL_MS*1000000L};
+	bool isHit;
+	if (!ponder.isActive){
+		return false;
+	}
+	isHit = (spChessGameGetHashKey(currentGame) == ponder.key && ponder.depth == (int)maxDepth);
+	if (!isHit){
+		spMinimaxStopPondering();
+		return false;
+	}
+	while (!__atomic_load_n(&ponder.isDone, __ATOMIC_ACQUIRE)){
+		if (__atomic_load_n(&handle->stop, __ATOMIC_RELAXED)){
+			spMinimaxStopSearch(&ponder.handle);
+			break;
+		}
+		nanosleep(&pollTime, NULL);
+	}
+	pthread_join(ponder.thread, NULL);
+	spChessGameDestroy(ponder.game);
+	ponder.isActive = false;
+	*move = ponder.bestMove;
+	if (ponder.handle.stats.depth < (int)maxDepth){ //the pondering has been stopped
+		return false;
+	}
+	mergeStats(&handle->stats, &ponder.handle.stats);
+	if (handle->progress != NULL){
+		handle->progress(ponder.handle.stats.depth, ponder.bestMove, handle->stats.nodes, handle->progressData);
+	}
+	return true;
+}
+
+/**
+ * Keeps the statistics of a completed search, to be returned by spMinimaxGetStats
+ *
+ * @param handle - The handle of the search
+ * @param startMs - The time the search has started at
+ */
+void setLastStats(SPMinimaxHandle *handle, long long startMs){
+	handle->stats.elapsedMs = spMiniMaxGetTimeMs() - startMs;
+	lastStats = handle->stats;
+}
 
 /**
  * Given a game state, this function evaluates the best move according to
@@ -7,18 +153,221 @@
  * specified length given by maxDepth. The current game state doesn't change
  * by this function including the history of previous moves.
  *
+ * If the position is the one pondered by spMinimaxStartPondering to maxDepth,
+ * the result of the pondering is returned (after it is completed). Otherwise the pondering is stopped,
+ * and the current position is searched, using the positions the pondering has stored in the hash.
+ *
  * @param currentGame - The current game state
  * @param maxDepth - The maximum depth of the miniMax algorithm
+ * @param handle - The handle to stop the search and get its progress
+ *                 (initialized by spMinimaxInitHandle), or NULL
  * @return
  * {{-1,-1},{-1,-1},-1,-1} if either currentGame is NULL or maxDepth <= 0.
  * On success the function returns a valid move
- * which is the best move for the current player.
+ * which is the best move for the current player, or the best move found so far if the search is stopped.
  */
-SPMove spMinimaxSuggestMove(SPChessGame* currentGame, unsigned int maxDepth){
+SPMove spMinimaxSuggestMove(SPChessGame* currentGame, unsigned int maxDepth, SPMinimaxHandle *handle){
+	SPMinimaxHandle localHandle;
+	SPMove move;
+	long long startMs = spMiniMaxGetTimeMs();
 	if (currentGame==NULL || maxDepth<=0){
 		return (SPMove){{-1,-1},{-1,-1},-1,-1};
 	}
-	return spMiniMax(currentGame, maxDepth);
+	if (handle == NULL){ //the statistics are collected anyway
+		spMinimaxInitHandle(&localHandle, NULL, NULL);
+		handle = &localHandle;
+	}
+	if (!finishPondering(currentGame, maxDepth, handle, &move)){
+		move = searchToDepth(currentGame, maxDepth, nSearchThreads, parallelMode, getTransTable(), handle);
+	}
+	setLastStats(handle, startMs);
+	return move;
+}
+
+/**
+ * Given a game state, this function evaluates the best move according to
+ * the current player within the specified time. The function searches to
+ * depth 1, 2, 3... and returns the best move found by the deepest search
+ * before the time has passed. The current game state doesn't change
+ * by this function including the history of previous moves.
+ *
+ * @param currentGame - The current game state
+ * @param timeMs - The time limit of the search in milliseconds
+ * @param handle - The handle to stop the search and get its progress
+ *                 (initialized by spMinimaxInitHandle), or NULL
+ * @return
+ * {{-1,-1},{-1,-1},-1,-1} if either currentGame is NULL or timeMs == 0.
+ * On success the function returns a valid move
+ * which is the best move for the current player, or the best move found so far if the search is stopped.
+ */
+SPMove spMinimaxSuggestMoveTimed(SPChessGame* currentGame, unsigned int timeMs, SPMinimaxHandle *handle){
+	SPMinimaxHandle localHandle;
+	SPMove move;
+	long long startMs = spMiniMaxGetTimeMs();
+	if (currentGame==NULL || timeMs==0){
+		return (SPMove){{-1,-1},{-1,-1},-1,-1};
+	}
+	if (handle == NULL){ //the statistics are collected anyway
+		spMinimaxInitHandle(&localHandle, NULL, NULL);
+		handle = &localHandle;
+	}
+	spMinimaxStopPondering();
+	move = spMiniMaxIterative(currentGame, SP_MINIMAX_MAX_PLY-1, timeMs, nSearchThreads, getTransTable(), handle, NULL);
+	setLastStats(handle, startMs);
+	return move;
+}
+
+/**
+ * Initializes a handle of a search, before the search starts.
+ *
+ * @param handle - The handle
+ * @param progress - The function called after every completed depth of the search, or NULL
+ * @param progressData - The data passed to progress
+ */
+void spMinimaxInitHandle(SPMinimaxHandle *handle, SPMinimaxProgressFunc progress, void *progressData){
+	handle->stop = 0;
+	memset(&handle->stats, 0, sizeof(handle->stats));
+	handle->progress = progress;
+	handle->progressData = progressData;
+}
+
+/**
+ * Asks the search of the specified handle to stop. The search checks the handle once every
+ * SP_MINIMAX_TIME_CHECK_INTERVAL nodes, and returns the best move it has found so far.
+ * May be called from any thread, or from a signal handler.
+ *
+ * @param handle - The handle of the search
+ */
+void spMinimaxStopSearch(SPMinimaxHandle *handle){
+	__atomic_store_n(&handle->stop, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Returns the statistics of the last search made by spMinimaxSuggestMove or spMinimaxSuggestMoveTimed.
+ * If the move was found by the pondering, its statistics are included.
+ *
+ * @return
+ * the statistics of the last search, all zero if no search has been made
+ */
+SPMinimaxStats spMinimaxGetStats(){
+	return lastStats;
+}
+
+/**
+ * Sets the size of the transposition table used by spMinimaxSuggestMove.
+ * The positions kept in the current table are removed.
+ *
+ * @param sizeMB - The size of the table in MB, 0 to search without a table
+ */
+void spMinimaxSetHashSize(unsigned int sizeMB){
+	spMinimaxCleanup(); //stops the pondering, which uses the table
+	hashSizeMB = sizeMB;
+}
+
+/**
+ * Sets the number of threads used by spMinimaxSuggestMove and spMinimaxSuggestMoveTimed (1 by default).
+ * With more than one thread the threads search the same position together,
+ * sharing the transposition table, and spMinimaxSuggestMove deepens its search
+ * iteratively up to maxDepth.
+ *
+ * @param nThreads - The number of threads (1 to SP_MINIMAX_MAX_THREADS),
+ *                   0 to use one thread per online processor
+ */
+void spMinimaxSetThreads(unsigned int nThreads){
+	if (nThreads == 0){
+		long nProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+		nThreads = (nProcessors > 0) ? (unsigned int)nProcessors : 1;
+	}
+	nSearchThreads = (nThreads < SP_MINIMAX_MAX_THREADS) ? nThreads : SP_MINIMAX_MAX_THREADS;
+}
+
+/**
+ * Sets the way the threads of spMinimaxSuggestMove share the work (SP_MINIMAX_LAZY_SMP by default).
+ * With SP_MINIMAX_ROOT_SPLIT the moves of the root are split between the threads,
+ * which search without the transposition table, and the suggested move depends only
+ * on the position and the depth. With SP_MINIMAX_YBWC the threads split the moves of nodes
+ * below the root too (Young Brothers Wait). spMinimaxSuggestMoveTimed always uses SP_MINIMAX_LAZY_SMP.
+ *
+ * @param mode - The parallel mode
+ */
+void spMinimaxSetParallelMode(SP_MINIMAX_PARALLEL_MODE mode){
+	parallelMode = mode;
+}
+
+/**
+ * Starts searching in the background while the user thinks (pondering).
+ * The user's move is predicted by the hash move of the current position, or by a search
+ * of depth SP_MINIMAX_PONDER_PREDICTION_DEPTH, and the position after it is searched to the
+ * difficulty level of the game, with the threads and the parallel mode of spMinimaxSuggestMove.
+ * A previous pondering is stopped first.
+ * The current game state doesn't change by this function.
+ *
+ * @param currentGame - The current game state, the user is the current player
+ */
+void spMinimaxStartPondering(SPChessGame* currentGame){
+	SPMove predictedMove;
+	SPPackedMove hashMove;
+	SPTransTableEntry entry;
+	bool isPredicted = false;
+	spMinimaxStopPondering();
+	if (currentGame == NULL || currentGame->difficulty <= 0 ||
+			!spChessGameDoesPlayerHaveValidMoves(currentGame, currentGame->currentPlayer)){
+		return;
+	}
+	if (getTransTable() != NULL && spTransTableProbe(transTable, spChessGameGetHashKey(currentGame), &entry) &&
+			spTransTableGetMove(&entry, &hashMove)){
+		predictedMove = spChessGameUnpackMove(hashMove);
+		isPredicted = (spChessGameisValidMove(currentGame, predictedMove) == SP_CHESS_GAME_LEGAL_MOVE);
+	}
+	if (!isPredicted){
+		predictedMove = spMiniMax(currentGame, SP_MINIMAX_PONDER_PREDICTION_DEPTH, transTable, NULL);
+		if (predictedMove.start.row < 0){
+			return;
+		}
+	}
+	ponder.game = spChessGameCopy(currentGame);
+	if (ponder.game == NULL){
+		return;
+	}
+	spChessGameSetMove(ponder.game, predictedMove);
+	if (!spChessGameDoesPlayerHaveValidMoves(ponder.game, ponder.game->currentPlayer)){ //the game is over
+		spChessGameDestroy(ponder.game);
+		return;
+	}
+	ponder.key = spChessGameGetHashKey(ponder.game);
+	ponder.depth = currentGame->difficulty;
+	ponder.nThreads = nSearchThreads;
+	ponder.parallelMode = parallelMode;
+	ponder.transTable = transTable;
+	ponder.isDone = 0;
+	spMinimaxInitHandle(&ponder.handle, NULL, NULL);
+	ponder.isActive = (pthread_create(&ponder.thread, NULL, ponderThreadMain, &ponder) == 0);
+	if (!ponder.isActive){
+		spChessGameDestroy(ponder.game);
+	}
+}
+
+/**
+ * Stops the background search started by spMinimaxStartPondering, if there's one.
+ * The positions it has searched stay in the hash.
+ */
+void spMinimaxStopPondering(){
+	if (!ponder.isActive){
+		return;
+	}
+	spMinimaxStopSearch(&ponder.handle);
+	pthread_join(ponder.thread, NULL);
+	spChessGameDestroy(ponder.game);
+	ponder.isActive = false;
+}
+
+/**
+ * Frees all memory resources used by spMinimaxSuggestMove.
+ */
+void spMinimaxCleanup(){
+	spMinimaxStopPondering();
+	spTransTableDestroy(transTable);
+	transTable = NULL;
 }
 
 
@@ -2,6 +2,22 @@
 #define SPMINIMAX_H_
 
 #include "SPChessGame.h"
+#include "SPMinimaxNode.h"
+
+//Definitions
+#define SP_MINIMAX_DEFAULT_HASH_SIZE_MB 16
+#define SP_MINIMAX_MAX_THREADS 64
+#define SP_MINIMAX_PONDER_PREDICTION_DEPTH 2 //the depth of the search that predicts the user's move
+#define SP_MINIMAX_PONDER_POLL_MS 1 //how often a search waiting for the pondering checks its handle
+
+/**
+ * The ways the threads of a search share the work
+ */
+typedef enum sp_minimax_parallel_mode_t {
+	SP_MINIMAX_LAZY_SMP, //all the threads search the whole tree, sharing the transposition table
+	SP_MINIMAX_ROOT_SPLIT, //the moves of the root are split between the threads, the result is reproducible
+	SP_MINIMAX_YBWC //the moves of every node are split between idle threads once its first move has been searched
+} SP_MINIMAX_PARALLEL_MODE;
 
 /**
  * Given a game state, this function evaluates the best move according to
@@ -9,14 +25,119 @@
  * specified length given by maxDepth. The current game state doesn't change
  * by this function including the history of previous moves.
  *
+ * If the position is the one pondered by spMinimaxStartPondering to maxDepth,
+ * the result of the pondering is returned (after it is completed). Otherwise the pondering is stopped,
+ * and the current position is searched, using the positions the pondering has stored in the hash.
+ *
  * @param currentGame - The current game state
  * @param maxDepth - The maximum depth of the miniMax algorithm
+ * @param handle - The handle to stop the search and get its progress
+ *                 (initialized by spMinimaxInitHandle), or NULL
  * @return
  * {{-1,-1},{-1,-1},-1,-1} if either currentGame is NULL or maxDepth <= 0.
  * On success the function returns a valid move
- * which is the best move for the current player.
+ * which is the best move for the current player, or the best move found so far if the search is stopped.
  */
 SPMove spMinimaxSuggestMove(SPChessGame* currentGame,
-		unsigned int maxDepth);
+		unsigned int maxDepth, SPMinimaxHandle *handle);
+
+/**
+ * Given a game state, this function evaluates the best move according to
+ * the current player within the specified time. The function searches to
+ * depth 1, 2, 3... and returns the best move found by the deepest search
+ * before the time has passed. The current game state doesn't change
+ * by this function including the history of previous moves.
+ *
+ * @param currentGame - The current game state
+ * @param timeMs - The time limit of the search in milliseconds
+ * @param handle - The handle to stop the search and get its progress
+ *                 (initialized by spMinimaxInitHandle), or NULL
+ * @return
+ * {{-1,-1},{-1,-1},-1,-1} if either currentGame is NULL or timeMs == 0.
+ * On success the function returns a valid move
+ * which is the best move for the current player, or the best move found so far if the search is stopped.
+ */
+SPMove spMinimaxSuggestMoveTimed(SPChessGame* currentGame,
+		unsigned int timeMs, SPMinimaxHandle *handle);
+
+/**
+ * Initializes a handle of a search, before the search starts.
+ *
+ * @param handle - The handle
+ * @param progress - The function called after every completed depth of the search, or NULL
+ * @param progressData - The data passed to progress
+ */
+void spMinimaxInitHandle(SPMinimaxHandle *handle, SPMinimaxProgressFunc progress, void *progressData);
+
+/**
+ * Asks the search of the specified handle to stop. The search checks the handle once every
+ * SP_MINIMAX_TIME_CHECK_INTERVAL nodes, and returns the best move it has found so far.
+ * May be called from any thread, or from a signal handler.
+ *
+ * @param handle - The handle of the search
+ */
+void spMinimaxStopSearch(SPMinimaxHandle *handle);
+
+/**
+ * Returns the statistics of the last search made by spMinimaxSuggestMove or spMinimaxSuggestMoveTimed.
+ * If the move was found by the pondering, its statistics are included.
+ *
+ * @return
+ * the statistics of the last search, all zero if no search has been made
+ */
+SPMinimaxStats spMinimaxGetStats();
+
+/**
+ * Sets the size of the transposition table used by spMinimaxSuggestMove.
+ * The positions kept in the current table are removed.
+ *
+ * @param sizeMB - The size of the table in MB, 0 to search without a table
+ */
+void spMinimaxSetHashSize(unsigned int sizeMB);
+
+/**
+ * Sets the number of threads used by spMinimaxSuggestMove and spMinimaxSuggestMoveTimed (1 by default).
+ * With more than one thread the threads search the same position together,
+ * sharing the transposition table, and spMinimaxSuggestMove deepens its search
+ * iteratively up to maxDepth.
+ *
+ * @param nThreads - The number of threads (1 to SP_MINIMAX_MAX_THREADS),
+ *                   0 to use one thread per online processor
+ */
+void spMinimaxSetThreads(unsigned int nThreads);
+
+/**
+ * Sets the way the threads of spMinimaxSuggestMove share the work (SP_MINIMAX_LAZY_SMP by default).
+ * With SP_MINIMAX_ROOT_SPLIT the moves of the root are split between the threads,
+ * which search without the transposition table, and the suggested move depends only
+ * on the position and the depth. With SP_MINIMAX_YBWC the threads split the moves of nodes
+ * below the root too (Young Brothers Wait). spMinimaxSuggestMoveTimed always uses SP_MINIMAX_LAZY_SMP.
+ *
+ * @param mode - The parallel mode
+ */
+void spMinimaxSetParallelMode(SP_MINIMAX_PARALLEL_MODE mode);
+
+/**
+ * Starts searching in the background while the user thinks (pondering).
+ * The user's move is predicted by the hash move of the current position, or by a search
+ * of depth SP_MINIMAX_PONDER_PREDICTION_DEPTH, and the position after it is searched to the
+ * difficulty level of the game, with the threads and the parallel mode of spMinimaxSuggestMove.
+ * A previous pondering is stopped first.
+ * The current game state doesn't change by this function.
+ *
+ * @param currentGame - The current game state, the user is the current player
+ */
+void spMinimaxStartPondering(SPChessGame* currentGame);
+
+/**
+ * Stops the background search started by spMinimaxStartPondering, if there's one.
+ * The positions it has searched stay in the hash.
+ */
+void spMinimaxStopPondering();
+
+/**
+ * Frees all memory resources used by spMinimaxSuggestMove.
+ */
+void spMinimaxCleanup();
 
 #endif
@@ -1,9 +1,268 @@
+#define _POSIX_C_SOURCE 200112L //for clock_gettime and pthreads
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <limits.h>
+#include <time.h>
+#include <string.h>
+#include <sched.h>
 #include "SPMinimaxNode.h"
 
+/********************Prototypes**************************/
+
+int spMiniMaxAlphaBeta(SPMinimaxSearch *search, SPChessGame* src, unsigned int depth, bool isMax, int a, int b, SPPackedMove *bestMove);
+bool canSplit(SPMinimaxSearch *search, unsigned int depth);
+void splitNode(SPMinimaxSearch *search, SPChessGame *src, unsigned int depth, bool isMax,
+		int *a, int *b, int *parentScore, SPPackedMove *currBestMove, SPPackedMove *moves, int *scores, int first, int size);
+
+/*******************Implementation***********************/
+
+/** Returns the time of a monotonic clock in milliseconds
+ * @return
+ * the current time in ms
+ * */
+long long spMiniMaxGetTimeMs(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec*1000 + ts.tv_nsec/1000000;
+}
+
+/** Checks if the specified split point, or a split point above it, has been cut off
+ *
+ * @param splitPoint - the split point, or NULL
+ * @return
+ * true - if the moves searched for the split point are no longer needed
+ * false - otherwise
+ * */
+bool isSplitPointAborted(const SPMinimaxSplitPoint *splitPoint){
+	for (; splitPoint != NULL; splitPoint = splitPoint->parent){
+		if (__atomic_load_n(&splitPoint->cutoff, __ATOMIC_RELAXED)){
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Checks if the result of the current node is no longer needed:
+ * the search has been stopped, or a split point the thread is searching for has been cut off
+ *
+ * @param search - the search state
+ * @return
+ * true - if the search of the node should be abandoned
+ * false - otherwise
+ * */
+bool isSearchAborted(SPMinimaxSearch *search){
+	return search->stopped || isSplitPointAborted(search->splitPoint);
+}
+
+/** Adds the nodes searched since the last call to the node count of the handle of the search
+ *
+ * @param search - the search state
+ * */
+void countNodes(SPMinimaxSearch *search){
+	if (search->handle != NULL){
+		__atomic_add_fetch(&search->handle->stats.nodes, search->nodes - search->countedNodes, __ATOMIC_RELAXED);
+	}
+	search->countedNodes = search->nodes;
+}
+
+/** Adds the statistics of the search to the statistics of its handle, and clears them.
+ * Called by every thread of a search when it is done.
+ *
+ * @param search - the search state
+ * */
+void addStats(SPMinimaxSearch *search){
+	SPMinimaxStats *stats = (search->handle != NULL) ? &search->handle->stats : NULL;
+	int maxPly;
+	countNodes(search);
+	if (stats != NULL){
+		__atomic_add_fetch(&stats->leafEvals, search->stats.leafEvals, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&stats->interiorNodes, search->stats.interiorNodes, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&stats->movesSearched, search->stats.movesSearched, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&stats->betaCutoffs, search->stats.betaCutoffs, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&stats->firstMoveCutoffs, search->stats.firstMoveCutoffs, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&stats->ttProbes, search->stats.ttProbes, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&stats->ttHits, search->stats.ttHits, __ATOMIC_RELAXED);
+		maxPly = __atomic_load_n(&stats->maxPly, __ATOMIC_RELAXED);
+		while (search->stats.maxPly > maxPly &&
+				!__atomic_compare_exchange_n(&stats->maxPly, &maxPly, search->stats.maxPly, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+	}
+	memset(&search->stats, 0, sizeof(search->stats));
+}
+
+/** Sets the completed depth of the search, and calls the progress function of its handle, if there's one
+ *
+ * @param search - the search state
+ * @param depth - the depth completed
+ * @param bestMove - the best move found at this depth
+ * */
+void reportProgress(SPMinimaxSearch *search, int depth, SPPackedMove bestMove){
+	SPMinimaxHandle *handle = search->handle;
+	countNodes(search);
+	if (handle == NULL){
+		return;
+	}
+	handle->stats.depth = depth;
+	if (handle->progress != NULL){
+		handle->progress(depth, spChessGameUnpackMove(bestMove), __atomic_load_n(&handle->stats.nodes, __ATOMIC_RELAXED), handle->progressData);
+	}
+}
+
+/** Counts the current node, and its ply in the statistics, and checks if the deadline of the search has passed,
+ * or if another thread has asked the search to stop.
+ * The clock and the handle are read once every SP_MINIMAX_TIME_CHECK_INTERVAL nodes.
+ *
+ * @param search - the search state
+ * @return
+ * true - if the search has been stopped
+ * false - otherwise
+ * */
+bool isSearchStopped(SPMinimaxSearch *search){
+	search->nodes++;
+	if (search->ply > search->stats.maxPly){
+		search->stats.maxPly = search->ply;
+	}
+	if (!search->stopped && search->nodes % SP_MINIMAX_TIME_CHECK_INTERVAL == 0){
+		countNodes(search);
+		if ((search->deadline != SP_MINIMAX_NO_DEADLINE && spMiniMaxGetTimeMs() >= search->deadline) ||
+				(search->handle != NULL && __atomic_load_n(&search->handle->stop, __ATOMIC_RELAXED))){
+			search->stopped = true;
+		}
+	}
+	if (!search->stopped && search->stopFlag != NULL && __atomic_load_n(search->stopFlag, __ATOMIC_RELAXED)){
+		search->stopped = true;
+	}
+	return isSearchAborted(search);
+}
+
+/** Initializes the state of a new search
+ *
+ * @param search - the search state
+ * @param transTable - the transposition table, or NULL
+ * @param deadline - the time in ms at which the search stops, or SP_MINIMAX_NO_DEADLINE
+ * */
+void initSearch(SPMinimaxSearch *search, SPTransTable *transTable, long long deadline){
+	search->ply = 0;
+	search->transTable = transTable;
+	search->deadline = deadline;
+	search->nodes = 0;
+	search->countedNodes = 0;
+	memset(&search->stats, 0, sizeof(search->stats));
+	search->stopped = false;
+	search->stopFlag = NULL;
+	search->handle = NULL;
+	search->ybwc = NULL;
+	search->threadId = 0;
+	search->splitPoint = NULL;
+	for (int ply=0; ply<SP_MINIMAX_MAX_PLY; ply++){
+		for (int i=0; i<SP_MINIMAX_N_KILLERS; i++){
+			search->killers[ply][i] = SP_PACKED_MOVE_NONE;
+		}
+	}
+	memset(search->history, 0, sizeof(search->history));
+}
+
+/** Returns the piece on the specified square of the board
+ *
+ * @param src - the game source
+ * @param square - the square index
+ * @return
+ * the piece on the square
+ * */
+char getPieceOnSquare(SPChessGame *src, int square){
+	return src->gameBoard[spBitboardRow(square)][spBitboardCol(square)];
+}
+
+/** Gives every move a score which estimates how likely it is to cause a cut-off.
+ * The hash move is scored first, then captures by most valuable victim / least valuable attacker,
+ * then the killer moves of the current ply, then the other quiet moves by their history.
+ *
+ * @param search - the search state
+ * @param src - the game source
+ * @param moves - the moves array
+ * @param scores - array to get the score of each move
+ * @param size - the number of moves in the array
+ * @param hashMove - the best move stored in the transposition table, or SP_PACKED_MOVE_NONE if there's none
+ * */
+void scoreMoves(SPMinimaxSearch *search, SPChessGame *src, SPPackedMove *moves, int *scores, int size, SPPackedMove hashMove){
+	SPPackedMove *killers = search->killers[search->ply];
+	int (*history)[SP_BITBOARD_N_SQUARES] = search->history[src->currentPlayer];
+	int victim, attacker;
+	for (int i=0; i<size; i++){
+		if (spPackedMoveIsSame(moves[i], hashMove)){
+			scores[i] = SP_MINIMAX_HASH_MOVE_SCORE;
+		}
+		else if (spPackedMoveIsCapture(moves[i])){
+			victim = spChessGameGetPieceTypeScore(spChessGameGetPieceType(getPieceOnSquare(src, spPackedMoveDest(moves[i]))));
+			attacker = spChessGameGetPieceTypeScore(spChessGameGetPieceType(getPieceOnSquare(src, spPackedMoveStart(moves[i]))));
+			scores[i] = SP_MINIMAX_CAPTURE_SCORE + victim*SP_MINIMAX_VICTIM_WEIGHT - attacker;
+		}
+		else if (spPackedMoveIsSame(moves[i], killers[0])){
+			scores[i] = SP_MINIMAX_KILLER_SCORE + 1;
+		}
+		else if (spPackedMoveIsSame(moves[i], killers[1])){
+			scores[i] = SP_MINIMAX_KILLER_SCORE;
+		}
+		else {
+			scores[i] = history[spPackedMoveStart(moves[i])][spPackedMoveDest(moves[i])];
+		}
+	}
+}
+
+/** Moves the move with the highest score among the moves from index to the end of the array
+ * to the specified index, so the moves are sorted only as far as the search gets.
+ *
+ * @param moves - the moves array
+ * @param scores - the scores of the moves
+ * @param index - the index of the next move to be searched
+ * @param size - the number of moves in the array
+ * */
+void pickNextMove(SPPackedMove *moves, int *scores, int index, int size){
+	int best = index, tmpScore;
+	SPPackedMove tmpMove;
+	for (int i=index+1; i<size; i++){
+		if (scores[i] > scores[best]){
+			best = i;
+		}
+	}
+	if (best != index){
+		tmpMove = moves[index];
+		moves[index] = moves[best];
+		moves[best] = tmpMove;
+		tmpScore = scores[index];
+		scores[index] = scores[best];
+		scores[best] = tmpScore;
+	}
+}
+
+/** Records a quiet move which caused a cut-off as a killer move of the current ply,
+ * and raises its history score by depth^2. All the history scores of the player are halved
+ * once the score of the move reaches SP_MINIMAX_MAX_HISTORY_SCORE.
+ *
+ * @param search - the search state
+ * @param src - the game source
+ * @param move - the move which caused the cut-off
+ * @param depth - the remaining depth of the node
+ * */
+void updateQuietCutoff(SPMinimaxSearch *search, SPChessGame *src, SPPackedMove move, unsigned int depth){
+	SPPackedMove *killers = search->killers[search->ply];
+	int (*history)[SP_BITBOARD_N_SQUARES] = search->history[src->currentPlayer];
+	int start = spPackedMoveStart(move);
+	int dest = spPackedMoveDest(move);
+	if (!spPackedMoveIsSame(move, killers[0])){
+		killers[1] = killers[0];
+		killers[0] = move;
+	}
+	history[start][dest] += depth*depth;
+	if (history[start][dest] >= SP_MINIMAX_MAX_HISTORY_SCORE){
+		for (int i=0; i<SP_BITBOARD_N_SQUARES; i++){
+			for (int j=0; j<SP_BITBOARD_N_SQUARES; j++){
+				history[i][j] /= 2;
+			}
+		}
+	}
+}
+
 /** Updates the values of parentScore, alpha, beta, and bestMove.
  *
  * If the node is a max node of the miniMax tree,
@@ -21,7 +280,7 @@
  * @param currMove - the current move has been done in the minimax tree
  * @param bestMove - pointer to the best move
  * */
-void update(int *parentScore, int childScore, int *a, int *b, bool isMax, SPMove currMove, SPMove *bestMove){
+void update(int *parentScore, int childScore, int *a, int *b, bool isMax, SPPackedMove currMove, SPPackedMove *bestMove){
 	if((isMax && *parentScore < childScore) || (!isMax && childScore < *parentScore)){
 		*parentScore = childScore;
 		*bestMove = currMove;
@@ -34,11 +293,134 @@ void update(int *parentScore, int childScore, int *a, int *b, bool isMax, SPMove
 	}
 }
 
+/** Returns the score of a position in which the current player has no legal moves
+ *
+ * @param src - the game source
+ * @return
+ * SP_CHESS_GAME_MAX_SCORE - if white is in checkmate
+ * SP_CHESS_GAME_MIN_SCORE - if black is in checkmate
+ * SP_CHESS_GAME_DRAW_SCORE - if the current player isn't in check (a draw)
+ * */
+int getTerminalScore(SPChessGame *src){
+	if (spChessGameIsPlayerInCheck(src, src->currentPlayer)){ //current player in checkmate
+		if (src->currentPlayer == SP_CHESS_GAME_WHITE) {
+			return SP_CHESS_GAME_MAX_SCORE; //black wins
+		}
+		else {
+			return SP_CHESS_GAME_MIN_SCORE; //white wins
+		}
+	}
+	return SP_CHESS_GAME_DRAW_SCORE; //draw
+}
+
+/**
+ * Evaluates a leaf of the minimax tree by searching only the captures from it,
+ * until a quiet position is reached, so the score isn't taken in the middle of an exchange.
+ * The player to move may stand pat: its score is at least the static score of the position.
+ * Captures which can't bring the score back into the window even by the value of the captured
+ * piece and SP_MINIMAX_DELTA_MARGIN are skipped (delta pruning).
+ *
+ * @param search - The search state
+ * @param src - The game source
+ * @param isMax - Is the current player is maximizing or minimizing the score
+ * @param a - Alpha value
+ * @param b - Beta value
+ *
+ * @return
+ * The score of the node represented by the current game state
+ */
+int spMiniMaxQuiescence(SPMinimaxSearch *search, SPChessGame* src, bool isMax, int a, int b){
+	if (isSearchStopped(search)){
+		return 0;
+	}
+	int standPat = spChessGameGetScore(src);
+	search->stats.leafEvals++;
+	if (search->ply >= SP_MINIMAX_MAX_PLY-1){
+		return standPat;
+	}
+	//stand pat
+	if (isMax){
+		if (standPat >= b){
+			return standPat;
+		}
+		a = (a > standPat) ? a : standPat;
+	}
+	else {
+		if (standPat <= a){
+			return standPat;
+		}
+		b = (b < standPat) ? b : standPat;
+	}
+
+	int size=0, nCaptures=0, parentScore=standPat, childScore, victim;
+	SPPackedMove moves[SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES];
+	int scores[SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES];
+	SPPackedMove currBestMove;
+	SPUndoInfo *undo = &search->undoStack[search->ply];
+
+	spChessGameGenerateAllMoves(src, moves, &size);
+	for (int i=0; i<size; i++){ //keep only the captures
+		if (spPackedMoveIsCapture(moves[i])){
+			moves[nCaptures++] = moves[i];
+		}
+	}
+	scoreMoves(search, src, moves, scores, nCaptures, SP_PACKED_MOVE_NONE);
+	for (int k=0; k<nCaptures; k++){
+		pickNextMove(moves, scores, k, nCaptures);
+		//delta pruning
+		victim = spChessGameGetPieceTypeScore(spChessGameGetPieceType(getPieceOnSquare(src, spPackedMoveDest(moves[k]))))*SP_CHESS_GAME_SCORE_UNIT;
+		if ((isMax && standPat + victim + SP_MINIMAX_DELTA_MARGIN <= a) ||
+				(!isMax && standPat - victim - SP_MINIMAX_DELTA_MARGIN >= b)){
+			continue;
+		}
+		spChessGameMakeSearchMove(src, moves[k], undo);
+		search->ply++;
+		childScore = spMiniMaxQuiescence(search, src, !isMax, a, b);
+		search->ply--;
+		spChessGameUnmakeSearchMove(src, undo);
+		if (isSearchAborted(search)){
+			return 0;
+		}
+		update(&parentScore, childScore, &a, &b, isMax, moves[k], &currBestMove);
+		if (b <= a){ //cut-off
+			break;
+		}
+	}
+	return parentScore;
+}
+
+/** Sets the best move found so far when the search of the root is stopped.
+ * Does nothing below the root.
+ *
+ * @param search - the search state
+ * @param moves - the moves of the node, moves[0] is the first move searched
+ * @param currBestMove - the best of the moves searched, or SP_PACKED_MOVE_NONE if none has been searched
+ * @param bestMove - pointer to get the move
+ * */
+void setStoppedRootMove(SPMinimaxSearch *search, SPPackedMove *moves, SPPackedMove currBestMove, SPPackedMove *bestMove){
+	if (search->ply == 0){
+		*bestMove = (currBestMove == SP_PACKED_MOVE_NONE) ? moves[0] : currBestMove;
+	}
+}
+
 /**
  * Given a game state, this function evaluates the best move according to
  * the current player. The function initiates a MiniMax algorithm using alpha beta puirning up to a
  * specified length given by depth.
+ * Moves are made by spChessGameMakeSearchMove and recorded on search->undoStack.
+ * If search->transTable is not NULL, positions which were already searched deep enough
+ * are cut off by their stored score, the stored best move is searched first,
+ * and the result of the node is stored in the table.
+ * The other moves are searched in the order given by scoreMoves.
+ * Checkmate and stalemate are detected when a node has no legal moves to search,
+ * and the leaves are evaluated by spMiniMaxQuiescence.
+ * Once the deadline of the search has passed search->stopped is set,
+ * and the search returns without storing results. The score returned is then meaningless,
+ * but at the root bestMove is set to the best move found so far: the best of the moves
+ * which have been searched, or the first move in search order if none has.
+ * In a YBWC search (search->ybwc != NULL) the moves after the first one may be split between threads.
  *
+ * @param search - The search state
  * @param src - The game source
  * @param depth - The maximum depth of the miniMax algorithm
  * @param isMax - Is the current player is maximizing or minimizing the score
@@ -49,57 +431,104 @@ void update(int *parentScore, int childScore, int *a, int *b, bool isMax, SPMove
  * @return
  * The score of the node represented by the current game state in the minimax tree
  */
-int spMiniMaxAlphaBeta(SPChessGame* src, unsigned int depth, bool isMax, int a, int b, SPMove *bestMove){
-	if (!spChessGameDoesPlayerHaveValidMoves(src, src->currentPlayer)){ //no legal moves
-		if (spChessGameIsPlayerInCheck(src, src->currentPlayer)){ //current player in checkmate
-			if (src->currentPlayer == SP_CHESS_GAME_WHITE) {
-				return SP_CHESS_GAME_MAX_SCORE; //black wins
-			}
-			else {
-				return SP_CHESS_GAME_MIN_SCORE; //white wins
-
-			}
-		}
-		else {//draw
-			return SP_CHESS_GAME_DRAW_SCORE;
-		}
+int spMiniMaxAlphaBeta(SPMinimaxSearch *search, SPChessGame* src, unsigned int depth, bool isMax, int a, int b, SPPackedMove *bestMove){
+	if (depth == 0 && spChessGameDoesPlayerHaveValidMoves(src, src->currentPlayer)){
+		return spMiniMaxQuiescence(search, src, isMax, a, b); //the leaf is counted by the quiescence search
+	}
+	if (isSearchStopped(search) && search->ply > 0){ //the root still sets a move
+		return 0;
 	}
-	if (depth == 0){	//the node is a leaf
-		return src->scoreFunc(src);
+	if (depth == 0){	//the node is a leaf with no legal moves
+		return getTerminalScore(src);
 	}
 
 
 	int size=0, parentScore, childScore;
-	SPMove currBestMove = {{INT_MIN,INT_MAX},{INT_MIN,INT_MAX},0,0};
-	SPMove moves[SP_CHESS_GAME_MAX_NUMBER_OF_MOVES];
-	SPCoordinate coord;
-	char pieceRemoved;
+	int alpha = a, beta = b; //the window the node was searched with
+	SPPackedMove currBestMove = SP_PACKED_MOVE_NONE;
+	SPPackedMove moves[SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES];
+	int scores[SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES];
+	SPPackedMove hashMove = SP_PACKED_MOVE_NONE;
+	SPUndoInfo *undo = &search->undoStack[search->ply];
+	SPTransTableEntry entry;
+	SP_TRANS_TABLE_BOUND bound;
 	parentScore = (isMax) ? INT_MIN : INT_MAX;
 
-	for (int j=0;j<8;j++){
-		for (int i=7;i>=0;i--){
-			coord.row = i; coord.col = j;
-			if (spChessGameGetPieceColor(spChessGameGetPieceAt(src,i,j))==src->currentPlayer){
-				spChessGameGetMoves(src, coord, moves,&size, false);
-				for (int k=0;k<size;k++){
-					//set move
-					pieceRemoved = spChessGameGetPieceAt(src, moves[k].dest.row, moves[k].dest.col);
-					spChessGameSetMove(src,moves[k]);
-					//compute child score
-					childScore = spMiniMaxAlphaBeta(src, depth-1, !isMax, a, b, bestMove);
-					//undo move
-					undoMove(src, moves[k], pieceRemoved);
-					spChessGameChangePlayer(src);
-					//update the values of parentScore, a, b, currBestMove
-					update(&parentScore, childScore, &a, &b, isMax, moves[k], &currBestMove);
-					if (b <= a){ //cut-off
-						*bestMove = currBestMove;
-						return parentScore;
-					}
+	if (search->transTable != NULL){
+		search->stats.ttProbes++;
+	}
+	if (search->transTable != NULL && spTransTableProbe(search->transTable, spChessGameGetHashKey(src), &entry)){
+		search->stats.ttHits++;
+		//the root always searches, to get the best move
+		if (search->ply > 0 && entry.depth >= (int)depth &&
+				(entry.bound == SP_TRANS_TABLE_EXACT ||
+				(entry.bound == SP_TRANS_TABLE_LOWER && entry.score >= b) ||
+				(entry.bound == SP_TRANS_TABLE_UPPER && entry.score <= a))){
+			return entry.score;
+		}
+		spTransTableGetMove(&entry, &hashMove);
+	}
+
+	spChessGameGenerateAllMoves(src, moves, &size);
+	if (size == 0){ //no legal moves
+		return getTerminalScore(src);
+	}
+	scoreMoves(search, src, moves, scores, size, hashMove);
+	search->stats.interiorNodes++;
+	for (int k=0;k<size;k++){
+		if (k > 0 && canSplit(search, depth)){ //the eldest brother has been searched
+			splitNode(search, src, depth, isMax, &a, &b, &parentScore, &currBestMove, moves, scores, k, size);
+			if (isSearchAborted(search)){
+				setStoppedRootMove(search, moves, currBestMove, bestMove);
+				return 0;
+			}
+			if (b <= a){
+				search->stats.betaCutoffs++;
+				if (!spPackedMoveIsCapture(currBestMove)){
+					updateQuietCutoff(search, src, currBestMove, depth);
 				}
 			}
+			break;
+		}
+		pickNextMove(moves, scores, k, size);
+		//set move
+		spChessGameMakeSearchMove(src, moves[k], undo);
+		search->stats.movesSearched++;
+		search->ply++;
+		//compute child score
+		childScore = spMiniMaxAlphaBeta(search, src, depth-1, !isMax, a, b, bestMove);
+		//undo move
+		search->ply--;
+		spChessGameUnmakeSearchMove(src, undo);
+		if (isSearchAborted(search)){ //the result of the child is incomplete
+			setStoppedRootMove(search, moves, currBestMove, bestMove);
+			return 0;
+		}
+		//update the values of parentScore, a, b, currBestMove
+		update(&parentScore, childScore, &a, &b, isMax, moves[k], &currBestMove);
+		if (b <= a){ //cut-off
+			search->stats.betaCutoffs++;
+			if (k == 0){
+				search->stats.firstMoveCutoffs++;
+			}
+			if (!spPackedMoveIsCapture(moves[k])){
+				updateQuietCutoff(search, src, moves[k], depth);
+			}
+			break;
 		}
 	}
+	if (search->transTable != NULL){
+		if (parentScore <= alpha){
+			bound = SP_TRANS_TABLE_UPPER;
+		}
+		else if (parentScore >= beta){
+			bound = SP_TRANS_TABLE_LOWER;
+		}
+		else {
+			bound = SP_TRANS_TABLE_EXACT;
+		}
+		spTransTableStore(search->transTable, spChessGameGetHashKey(src), depth, bound, parentScore, currBestMove);
+	}
 	*bestMove = currBestMove;
 	return parentScore;
 }
@@ -109,23 +538,689 @@ int spMiniMaxAlphaBeta(SPChessGame* src, unsigned int depth, bool isMax, int a,
  * the current player. The function initiates a MiniMax algorithm using alpha beta puirning up to a
  * specified length given by maxDepth. The current game state doesn't change
  * by this function including the history of previous moves.
+ * The results of the search are stored in transTable and are used
+ * to cut off and order the moves of positions that were already searched.
  *
  * @param currentGame - The current game state
  * @param maxDepth - The maximum depth of the miniMax algorithm
+ * @param transTable - The transposition table, or NULL to search without it
+ * @param handle - The handle to stop the search and get its progress, or NULL
  * @return
  * {{-1,-1},{-1,-1},0,0} if a memory allocation error has occurred.
  * On success the function returns a valid move
- * which is the best move for the current player.
+ * which is the best move for the current player, or the best move found so far if the search is stopped.
  */
-SPMove spMiniMax (SPChessGame* src, int depth){
+SPMove spMiniMax (SPChessGame* src, int depth, SPTransTable *transTable, SPMinimaxHandle *handle){
 	SPChessGame *copy = spChessGameCopy(src);
-	SPMove bestMove = {{-1,-1},{-1,-1},0,0};
+	SPPackedMove bestMove = SP_PACKED_MOVE_NONE;
+	SPMinimaxSearch search;
 	if (!copy){
-		return bestMove;
+		return spChessGameUnpackMove(bestMove);
+	}
+	if (depth >= SP_MINIMAX_MAX_PLY){
+		depth = SP_MINIMAX_MAX_PLY-1;
 	}
+	initSearch(&search, transTable, SP_MINIMAX_NO_DEADLINE);
+	search.handle = handle;
 	bool isMax = (src->currentPlayer == SP_CHESS_GAME_BLACK);
-	spMiniMaxAlphaBeta(copy, depth, isMax, INT_MIN, INT_MAX, &bestMove);
+	spMiniMaxAlphaBeta(&search, copy, depth, isMax, INT_MIN, INT_MAX, &bestMove);
+	addStats(&search);
+	if (!search.stopped){
+		reportProgress(&search, depth, bestMove);
+	}
 	spChessGameDestroy(copy);
-	return bestMove;
+	return spChessGameUnpackMove(bestMove);
 }
 
+/**
+ * Runs the iterative deepening search of a single thread on its own copy of the game:
+ * searches to depth thread->firstDepth, thread->firstDepth+1... up to thread->maxDepth,
+ * until the deadline passes or the search is stopped by another thread.
+ * The best move found so far by an iteration which is stopped is kept, but its depth isn't completed.
+ * The first iteration of the main thread has no deadline,
+ * so it always completes unless the search is stopped by its handle.
+ * The main thread (threadId 0) reports every completed iteration to the handle.
+ *
+ * @param thread - the thread state, its bestMove and completedDepth are set by the function
+ */
+void iterativeDeepening(SPMinimaxThread *thread){
+	SPPackedMove iterationMove;
+	int score;
+	bool isMax = (thread->game->currentPlayer == SP_CHESS_GAME_BLACK);
+	for (int depth=thread->firstDepth; depth<=thread->maxDepth; depth++){
+		iterationMove = SP_PACKED_MOVE_NONE;
+		score = spMiniMaxAlphaBeta(&thread->search, thread->game, depth, isMax, INT_MIN, INT_MAX, &iterationMove);
+		if (thread->search.stopped){
+			if (iterationMove != SP_PACKED_MOVE_NONE){
+				thread->bestMove = iterationMove;
+			}
+			break;
+		}
+		thread->bestMove = iterationMove;
+		thread->completedDepth = depth;
+		if (thread->search.threadId == 0){
+			reportProgress(&thread->search, depth, iterationMove);
+		}
+		//a checkmate has been found, deeper iterations won't change the result
+		if (score == SP_CHESS_GAME_MAX_SCORE || score == SP_CHESS_GAME_MIN_SCORE){
+			break;
+		}
+		if (thread->deadline != SP_MINIMAX_NO_DEADLINE && spMiniMaxGetTimeMs() >= thread->deadline){
+			break;
+		}
+		//the killers and history of the previous iterations are kept
+		thread->search.deadline = thread->deadline;
+	}
+	addStats(&thread->search);
+}
+
+/**
+ * The start routine of a helper thread
+ *
+ * @param arg - the thread state (SPMinimaxThread*)
+ * @return NULL
+ */
+void* helperThreadMain(void *arg){
+	iterativeDeepening((SPMinimaxThread*)arg);
+	return NULL;
+}
+
+/**
+ * Given a game state, this function evaluates the best move according to
+ * the current player, by searching to depth 1, 2, 3... up to maxDepth
+ * until the specified time has passed. The current game state doesn't change
+ * by this function including the history of previous moves.
+ *
+ * The search runs on nThreads threads (Lazy SMP). Every thread searches the same root
+ * on its own copy of the game, and the threads share only the transposition table,
+ * so the work of one thread cuts off and orders the search of the others.
+ * Every other helper starts at depth 2 instead of depth 1, so the threads are
+ * spread over different iterations. The helpers are stopped once the main thread is done,
+ * and the best move of the deepest iteration completed by any thread is returned
+ * (the main thread's move on a tie).
+ *
+ * @param src - The current game state
+ * @param maxDepth - The maximum depth of the miniMax algorithm
+ * @param timeMs - The time limit of the search in milliseconds, or SP_MINIMAX_NO_TIME_LIMIT
+ * @param nThreads - The number of threads, if a helper can't be created the search runs without it
+ * @param transTable - The transposition table, or NULL to search without it
+ * @param handle - The handle to stop the search and get its progress, or NULL
+ * @param completedDepth - If not NULL, pointer to get the depth of the deepest completed iteration,
+ *                         0 if the search has been stopped before any iteration was completed
+ * @return
+ * {{-1,-1},{-1,-1},0,0} if a memory allocation error has occurred.
+ * Otherwise the function returns a valid move which is the best move for the current player.
+ * If the last iteration is stopped, its best move so far is returned.
+ */
+SPMove spMiniMaxIterative (SPChessGame* src, int maxDepth, unsigned int timeMs, unsigned int nThreads, SPTransTable *transTable,
+		SPMinimaxHandle *handle, int *completedDepth){
+	SPPackedMove bestMove = SP_PACKED_MOVE_NONE;
+	SPMinimaxThread *threads;
+	unsigned int nCopies = 0;
+	int stop = 0; //set when the main thread is done, to stop the helpers
+	if (nThreads < 1){
+		nThreads = 1;
+	}
+	if (maxDepth >= SP_MINIMAX_MAX_PLY){
+		maxDepth = SP_MINIMAX_MAX_PLY-1;
+	}
+	threads = (SPMinimaxThread*) calloc(nThreads, sizeof(SPMinimaxThread));
+	if (completedDepth != NULL){
+		*completedDepth = 0;
+	}
+	if (!threads){
+		return spChessGameUnpackMove(bestMove);
+	}
+	long long deadline = (timeMs == SP_MINIMAX_NO_TIME_LIMIT) ? SP_MINIMAX_NO_DEADLINE : spMiniMaxGetTimeMs() + timeMs;
+	for (; nCopies<nThreads; nCopies++){
+		SPMinimaxThread *thread = &threads[nCopies];
+		thread->game = spChessGameCopy(src);
+		if (!thread->game){
+			break;
+		}
+		thread->firstDepth = 1 + nCopies%2;
+		thread->maxDepth = maxDepth;
+		thread->deadline = deadline;
+		thread->bestMove = bestMove;
+		thread->completedDepth = 0;
+		if (nCopies == 0){ //the main thread
+			initSearch(&thread->search, transTable, SP_MINIMAX_NO_DEADLINE);
+		}
+		else {
+			initSearch(&thread->search, transTable, deadline);
+			thread->search.stopFlag = &stop;
+		}
+		thread->search.handle = handle;
+		thread->search.threadId = nCopies;
+	}
+	if (nCopies == 0){
+		free(threads);
+		return spChessGameUnpackMove(bestMove);
+	}
+	for (unsigned int i=1; i<nCopies; i++){
+		threads[i].isStarted = (pthread_create(&threads[i].thread, NULL, helperThreadMain, &threads[i]) == 0);
+	}
+	iterativeDeepening(&threads[0]);
+	__atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+
+	SPMinimaxThread *best = &threads[0];
+	for (unsigned int i=1; i<nCopies; i++){
+		if (threads[i].isStarted){
+			pthread_join(threads[i].thread, NULL);
+			if (threads[i].completedDepth > best->completedDepth){
+				best = &threads[i];
+			}
+		}
+	}
+	bestMove = best->bestMove;
+	if (handle != NULL){
+		handle->stats.depth = best->completedDepth;
+	}
+	if (completedDepth != NULL){
+		*completedDepth = best->completedDepth;
+	}
+	for (unsigned int i=0; i<nCopies; i++){
+		spChessGameDestroy(threads[i].game);
+	}
+	free(threads);
+	return spChessGameUnpackMove(bestMove);
+}
+
+/**
+ * Searches the root moves of a root split worker, and sets its bestScore and bestIndex.
+ * Only a move with a strictly better score replaces the best move,
+ * so the worker keeps the first of its moves which has the best score.
+ * If the search is stopped, only the moves whose search has been completed are considered.
+ *
+ * @param worker - the worker state
+ */
+void searchRootMoves(SPMinimaxRootWorker *worker){
+	int a = INT_MIN, b = INT_MAX, score;
+	bool isMax = (worker->game->currentPlayer == SP_CHESS_GAME_BLACK);
+	SPPackedMove childMove;
+	SPUndoInfo *undo = &worker->search.undoStack[0];
+	worker->bestIndex = -1;
+	worker->bestScore = (isMax) ? INT_MIN : INT_MAX;
+	for (int i=worker->firstIndex; i<worker->nMoves; i+=worker->step){
+		spChessGameMakeSearchMove(worker->game, worker->moves[i], undo);
+		worker->search.ply = 1;
+		score = spMiniMaxAlphaBeta(&worker->search, worker->game, worker->depth-1, !isMax, a, b, &childMove);
+		worker->search.ply = 0;
+		spChessGameUnmakeSearchMove(worker->game, undo);
+		if (worker->search.stopped){ //the score of the move is incomplete
+			break;
+		}
+		if (worker->bestIndex == -1 || (isMax && score > worker->bestScore) || (!isMax && score < worker->bestScore)){
+			worker->bestScore = score;
+			worker->bestIndex = i;
+		}
+		if (isMax){
+			a = (a > worker->bestScore) ? a : worker->bestScore;
+		}
+		else {
+			b = (b < worker->bestScore) ? b : worker->bestScore;
+		}
+	}
+	addStats(&worker->search);
+}
+
+/**
+ * The start routine of a root split worker thread
+ *
+ * @param arg - the worker state (SPMinimaxRootWorker*)
+ * @return NULL
+ */
+void* rootWorkerMain(void *arg){
+	searchRootMoves((SPMinimaxRootWorker*)arg);
+	return NULL;
+}
+
+/**
+ * Given a game state, this function evaluates the best move according to
+ * the current player, by splitting the moves of the root between nThreads workers.
+ * The current game state doesn't change by this function including the history of previous moves.
+ *
+ * The root moves are ordered once, and worker i searches the moves i, i+nThreads, i+2*nThreads...
+ * to the specified depth on its own copy of the game, with its own alpha beta window
+ * and without a transposition table. The best move is the first move in the root order
+ * which has the highest score, so the result doesn't depend on the timing of the threads
+ * (unless the search is stopped).
+ *
+ * @param src - The current game state
+ * @param depth - The maximum depth of the miniMax algorithm
+ * @param nThreads - The number of workers, a worker whose thread can't be created
+ *                   is run by the calling thread
+ * @param handle - The handle to stop the search and get its progress, or NULL
+ * @return
+ * {{-1,-1},{-1,-1},0,0} if a memory allocation error has occurred.
+ * On success the function returns a valid move
+ * which is the best move for the current player, or the best move found so far if the search is stopped.
+ */
+SPMove spMiniMaxRootSplit (SPChessGame* src, int depth, unsigned int nThreads, SPMinimaxHandle *handle){
+	SPPackedMove bestMove = SP_PACKED_MOVE_NONE;
+	SPPackedMove moves[SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES];
+	int scores[SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES];
+	SPMinimaxRootWorker *workers;
+	int size = 0, nWorkers, nCopies = 0, bestIndex = -1, bestScore = 0;
+	bool isStopped = false;
+	bool isMax = (src->currentPlayer == SP_CHESS_GAME_BLACK);
+	if (depth >= SP_MINIMAX_MAX_PLY){
+		depth = SP_MINIMAX_MAX_PLY-1;
+	}
+	if (depth < 1){
+		depth = 1;
+	}
+	spChessGameGenerateAllMoves(src, moves, &size);
+	if (size == 0){
+		return spChessGameUnpackMove(bestMove);
+	}
+	nWorkers = (nThreads < 1) ? 1 : ((int)nThreads < size) ? (int)nThreads : size;
+	workers = (SPMinimaxRootWorker*) calloc(nWorkers, sizeof(SPMinimaxRootWorker));
+	if (!workers){
+		return spChessGameUnpackMove(bestMove);
+	}
+	//order the root moves once, the same way for any number of workers
+	initSearch(&workers[0].search, NULL, SP_MINIMAX_NO_DEADLINE);
+	scoreMoves(&workers[0].search, src, moves, scores, size, SP_PACKED_MOVE_NONE);
+	for (int k=0; k<size; k++){
+		pickNextMove(moves, scores, k, size);
+	}
+	for (; nCopies<nWorkers; nCopies++){
+		SPMinimaxRootWorker *worker = &workers[nCopies];
+		worker->game = spChessGameCopy(src);
+		if (!worker->game){
+			break;
+		}
+		initSearch(&worker->search, NULL, SP_MINIMAX_NO_DEADLINE);
+		worker->search.handle = handle;
+		worker->search.threadId = nCopies;
+		worker->moves = moves;
+		worker->nMoves = size;
+		worker->firstIndex = nCopies;
+		worker->step = nWorkers;
+		worker->depth = depth;
+	}
+	if (nCopies < nWorkers){
+		for (int i=0; i<nCopies; i++){
+			spChessGameDestroy(workers[i].game);
+		}
+		free(workers);
+		return spChessGameUnpackMove(bestMove);
+	}
+	for (int i=1; i<nWorkers; i++){
+		workers[i].isStarted = (pthread_create(&workers[i].thread, NULL, rootWorkerMain, &workers[i]) == 0);
+	}
+	searchRootMoves(&workers[0]);
+	for (int i=1; i<nWorkers; i++){
+		if (workers[i].isStarted){
+			pthread_join(workers[i].thread, NULL);
+		}
+		else {
+			searchRootMoves(&workers[i]);
+		}
+	}
+	//merge: the highest score, and the first move in the root order on a tie
+	for (int i=0; i<nWorkers; i++){
+		isStopped = isStopped || workers[i].search.stopped;
+		if (workers[i].bestIndex == -1){
+			continue;
+		}
+		if (bestIndex == -1 || (isMax && workers[i].bestScore > bestScore) ||
+				(!isMax && workers[i].bestScore < bestScore) ||
+				(workers[i].bestScore == bestScore && workers[i].bestIndex < bestIndex)){
+			bestScore = workers[i].bestScore;
+			bestIndex = workers[i].bestIndex;
+		}
+	}
+	//if no move has been searched before the search was stopped, the first move in the root order is taken
+	bestMove = moves[(bestIndex == -1) ? 0 : bestIndex];
+	if (!isStopped){
+		reportProgress(&workers[0].search, depth, bestMove);
+	}
+	for (int i=0; i<nWorkers; i++){
+		spChessGameDestroy(workers[i].game);
+	}
+	free(workers);
+	return spChessGameUnpackMove(bestMove);
+}
+
+/** Sets the position of a game to the position of another game.
+ * The moves history of dest is kept.
+ *
+ * @param dest - the game to be set
+ * @param src - the game with the position
+ * */
+void copyPosition(SPChessGame *dest, const SPChessGame *src){
+	SPArrayList *recentMoves = dest->recentMoves;
+	*dest = *src;
+	dest->recentMoves = recentMoves;
+}
+
+/** Checks if a node of a YBWC search should be split between threads
+ *
+ * @param search - the search state
+ * @param depth - the remaining depth of the node
+ * @return
+ * true - if the search is a YBWC search, the node is far enough from the leaves,
+ *        and there's an idle thread to help
+ * false - otherwise
+ * */
+bool canSplit(SPMinimaxSearch *search, unsigned int depth){
+	return search->ybwc != NULL && depth >= SP_MINIMAX_MIN_SPLIT_DEPTH &&
+			search->ybwc->deques[search->threadId].size < SP_MINIMAX_MAX_PLY &&
+			__atomic_load_n(&search->ybwc->nIdle, __ATOMIC_RELAXED) > 0;
+}
+
+/** Checks if a split point is below another split point in the search tree
+ *
+ * @param splitPoint - the split point
+ * @param ancestor - the other split point
+ * @return
+ * true - if ancestor is above splitPoint
+ * false - otherwise
+ * */
+bool isSplitPointBelow(const SPMinimaxSplitPoint *splitPoint, const SPMinimaxSplitPoint *ancestor){
+	for (splitPoint = splitPoint->parent; splitPoint != NULL; splitPoint = splitPoint->parent){
+		if (splitPoint == ancestor){
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Looks for a split point with moves left on the deques of the other threads, from the top of each deque,
+ * and joins it: the number of its workers is increased.
+ *
+ * @param ybwc - the state of the YBWC search
+ * @param threadId - the index of the thread looking for work
+ * @param ancestor - if not NULL, only split points below it are joined
+ * @return
+ * the split point that has been joined, or NULL if there's none
+ * */
+SPMinimaxSplitPoint* stealSplitPoint(SPMinimaxYBWC *ybwc, int threadId, const SPMinimaxSplitPoint *ancestor){
+	SPMinimaxSplitDeque *deque;
+	SPMinimaxSplitPoint *splitPoint;
+	for (int i=1; i<ybwc->nThreads; i++){
+		deque = &ybwc->deques[(threadId+i) % ybwc->nThreads];
+		pthread_mutex_lock(&deque->lock);
+		for (int j=0; j<deque->size; j++){
+			splitPoint = deque->splitPoints[j];
+			if (ancestor != NULL && !isSplitPointBelow(splitPoint, ancestor)){
+				continue;
+			}
+			pthread_mutex_lock(&splitPoint->lock);
+			if (!splitPoint->cutoff && splitPoint->nextIndex < splitPoint->size){
+				splitPoint->nWorkers++;
+				pthread_mutex_unlock(&splitPoint->lock);
+				pthread_mutex_unlock(&deque->lock);
+				return splitPoint;
+			}
+			pthread_mutex_unlock(&splitPoint->lock);
+		}
+		pthread_mutex_unlock(&deque->lock);
+	}
+	return NULL;
+}
+
+/** Searches moves of a split point, one at a time, until no moves are left or the split point is cut off.
+ * The score of every move is merged into the split point by update.
+ *
+ * @param search - the search state of the thread
+ * @param game - the game of the thread, set to the position of the split point
+ * @param splitPoint - the split point
+ * */
+void searchSplitPointMoves(SPMinimaxSearch *search, SPChessGame *game, SPMinimaxSplitPoint *splitPoint){
+	SPMinimaxSplitPoint *prevSplitPoint = search->splitPoint;
+	int prevPly = search->ply, a, b, childScore;
+	SPPackedMove move, childMove;
+	SPUndoInfo *undo = &search->undoStack[splitPoint->ply];
+	search->splitPoint = splitPoint;
+	search->ply = splitPoint->ply;
+	while (true){
+		pthread_mutex_lock(&splitPoint->lock);
+		if (splitPoint->cutoff || splitPoint->nextIndex >= splitPoint->size){
+			pthread_mutex_unlock(&splitPoint->lock);
+			break;
+		}
+		move = splitPoint->moves[splitPoint->nextIndex++];
+		a = splitPoint->a;
+		b = splitPoint->b;
+		pthread_mutex_unlock(&splitPoint->lock);
+
+		spChessGameMakeSearchMove(game, move, undo);
+		search->stats.movesSearched++;
+		search->ply++;
+		childScore = spMiniMaxAlphaBeta(search, game, splitPoint->depth-1, !splitPoint->isMax, a, b, &childMove);
+		search->ply--;
+		spChessGameUnmakeSearchMove(game, undo);
+		if (isSearchAborted(search)){
+			break;
+		}
+
+		pthread_mutex_lock(&splitPoint->lock);
+		if (!splitPoint->cutoff){
+			update(&splitPoint->bestScore, childScore, &splitPoint->a, &splitPoint->b, splitPoint->isMax, move, &splitPoint->bestMove);
+			if (splitPoint->b <= splitPoint->a){ //cut-off
+				__atomic_store_n(&splitPoint->cutoff, 1, __ATOMIC_RELAXED);
+			}
+		}
+		pthread_mutex_unlock(&splitPoint->lock);
+	}
+	search->splitPoint = prevSplitPoint;
+	search->ply = prevPly;
+}
+
+/** Sets the game of a thread to the position of a split point it has joined,
+ * searches moves of the split point, and leaves it.
+ *
+ * @param search - the search state of the thread
+ * @param game - the game of the thread
+ * @param splitPoint - the split point, joined by stealSplitPoint
+ * */
+void joinSplitPoint(SPMinimaxSearch *search, SPChessGame *game, SPMinimaxSplitPoint *splitPoint){
+	copyPosition(game, &splitPoint->position);
+	searchSplitPointMoves(search, game, splitPoint);
+	pthread_mutex_lock(&splitPoint->lock);
+	splitPoint->nWorkers--;
+	pthread_mutex_unlock(&splitPoint->lock);
+}
+
+/** Searches the moves of a node from the specified index with the help of idle threads.
+ * The node becomes a split point at the bottom of the thread's deque, the thread searches its moves
+ * together with the threads that steal it, and then waits for them to finish,
+ * helping them with split points below the node meanwhile.
+ * The values of a, b, parentScore and currBestMove are updated with the scores of all the moves.
+ * If the handle of the search has been stopped meanwhile, search->stopped is set.
+ *
+ * @param search - the search state of the thread
+ * @param src - the game source, at the position of the node
+ * @param depth - the remaining depth of the node
+ * @param isMax - is the current node is max\min node
+ * @param a - pointer to alpha value
+ * @param b - pointer to beta value
+ * @param parentScore - pointer to the score of the node
+ * @param currBestMove - pointer to the best move of the node
+ * @param moves - the moves of the node
+ * @param scores - the ordering scores of the moves
+ * @param first - the index of the first move which hasn't been searched
+ * @param size - the number of moves
+ * */
+void splitNode(SPMinimaxSearch *search, SPChessGame *src, unsigned int depth, bool isMax,
+		int *a, int *b, int *parentScore, SPPackedMove *currBestMove, SPPackedMove *moves, int *scores, int first, int size){
+	SPMinimaxYBWC *ybwc = search->ybwc;
+	SPMinimaxSplitDeque *deque = &ybwc->deques[search->threadId];
+	SPMinimaxSplitPoint splitPoint;
+	SPMinimaxSplitPoint *other;
+	int nWorkers;
+
+	//the moves are given to the threads in search order
+	for (int k=first; k<size; k++){
+		pickNextMove(moves, scores, k, size);
+	}
+	pthread_mutex_init(&splitPoint.lock, NULL);
+	splitPoint.parent = search->splitPoint;
+	splitPoint.position = *src;
+	splitPoint.position.recentMoves = NULL;
+	splitPoint.ply = search->ply;
+	splitPoint.depth = depth;
+	splitPoint.isMax = isMax;
+	splitPoint.size = size-first;
+	memcpy(splitPoint.moves, moves+first, sizeof(SPPackedMove)*splitPoint.size);
+	splitPoint.nextIndex = 0;
+	splitPoint.a = *a;
+	splitPoint.b = *b;
+	splitPoint.bestScore = *parentScore;
+	splitPoint.bestMove = *currBestMove;
+	splitPoint.nWorkers = 1;
+	splitPoint.cutoff = 0;
+
+	pthread_mutex_lock(&deque->lock);
+	deque->splitPoints[deque->size++] = &splitPoint;
+	pthread_mutex_unlock(&deque->lock);
+
+	searchSplitPointMoves(search, src, &splitPoint);
+
+	//no moves are left, so no more threads can join
+	pthread_mutex_lock(&deque->lock);
+	deque->size--;
+	pthread_mutex_unlock(&deque->lock);
+	pthread_mutex_lock(&splitPoint.lock);
+	nWorkers = --splitPoint.nWorkers;
+	pthread_mutex_unlock(&splitPoint.lock);
+
+	__atomic_add_fetch(&ybwc->nIdle, 1, __ATOMIC_RELAXED);
+	while (nWorkers > 0){
+		other = stealSplitPoint(ybwc, search->threadId, &splitPoint);
+		if (other != NULL){
+			joinSplitPoint(search, src, other);
+			copyPosition(src, &splitPoint.position);
+		}
+		else {
+			sched_yield();
+		}
+		pthread_mutex_lock(&splitPoint.lock);
+		nWorkers = splitPoint.nWorkers;
+		pthread_mutex_unlock(&splitPoint.lock);
+	}
+	__atomic_sub_fetch(&ybwc->nIdle, 1, __ATOMIC_RELAXED);
+	pthread_mutex_destroy(&splitPoint.lock);
+	//a helper stopped by the handle has left its move out of the split point
+	if (search->handle != NULL && __atomic_load_n(&search->handle->stop, __ATOMIC_RELAXED)){
+		search->stopped = true;
+	}
+
+	*a = splitPoint.a;
+	*b = splitPoint.b;
+	*parentScore = splitPoint.bestScore;
+	*currBestMove = splitPoint.bestMove;
+}
+
+/**
+ * The start routine of a YBWC helper thread: joins split points of the other threads
+ * until the search is done.
+ *
+ * @param arg - the thread state (SPMinimaxYBWCThread*)
+ * @return NULL
+ */
+void* ybwcHelperMain(void *arg){
+	SPMinimaxYBWCThread *thread = (SPMinimaxYBWCThread*)arg;
+	SPMinimaxYBWC *ybwc = thread->ybwc;
+	SPMinimaxSplitPoint *splitPoint;
+	while (!__atomic_load_n(&ybwc->done, __ATOMIC_RELAXED)){
+		splitPoint = stealSplitPoint(ybwc, thread->search.threadId, NULL);
+		if (splitPoint == NULL){
+			sched_yield();
+			continue;
+		}
+		__atomic_sub_fetch(&ybwc->nIdle, 1, __ATOMIC_RELAXED);
+		joinSplitPoint(&thread->search, thread->game, splitPoint);
+		__atomic_add_fetch(&ybwc->nIdle, 1, __ATOMIC_RELAXED);
+	}
+	addStats(&thread->search);
+	return NULL;
+}
+
+/**
+ * Given a game state, this function evaluates the best move according to
+ * the current player, by a parallel alpha beta search to the specified depth
+ * using the Young Brothers Wait Concept. The current game state doesn't change
+ * by this function including the history of previous moves.
+ *
+ * A node is searched by a single thread until its first move (the eldest brother) has been searched.
+ * Then, if the node is at least SP_MINIMAX_MIN_SPLIT_DEPTH from the leaves and a thread is idle,
+ * the node becomes a split point on the deque of its thread, and idle threads steal it
+ * and search its other moves on their own game. A thread that waits for the helpers of its split point
+ * helps them with split points below its own. The threads share transTable.
+ *
+ * @param src - The current game state
+ * @param depth - The maximum depth of the miniMax algorithm
+ * @param nThreads - The number of threads, if a helper can't be created the search runs without it
+ * @param transTable - The transposition table, or NULL to search without it
+ * @param handle - The handle to stop the search and get its progress, or NULL
+ * @return
+ * {{-1,-1},{-1,-1},0,0} if a memory allocation error has occurred.
+ * On success the function returns a valid move
+ * which is the best move for the current player, or the best move found so far if the search is stopped.
+ */
+SPMove spMiniMaxYBWC (SPChessGame* src, int depth, unsigned int nThreads, SPTransTable *transTable, SPMinimaxHandle *handle){
+	SPPackedMove bestMove = SP_PACKED_MOVE_NONE;
+	SPMinimaxYBWC ybwc;
+	SPMinimaxYBWCThread *threads;
+	int nCopies = 0;
+	if (nThreads < 1){
+		nThreads = 1;
+	}
+	if (depth >= SP_MINIMAX_MAX_PLY){
+		depth = SP_MINIMAX_MAX_PLY-1;
+	}
+	ybwc.deques = (SPMinimaxSplitDeque*) calloc(nThreads, sizeof(SPMinimaxSplitDeque));
+	threads = (SPMinimaxYBWCThread*) calloc(nThreads, sizeof(SPMinimaxYBWCThread));
+	if (!ybwc.deques || !threads){
+		free(ybwc.deques);
+		free(threads);
+		return spChessGameUnpackMove(bestMove);
+	}
+	for (; nCopies<(int)nThreads; nCopies++){
+		threads[nCopies].game = spChessGameCopy(src);
+		if (!threads[nCopies].game){
+			break;
+		}
+		initSearch(&threads[nCopies].search, transTable, SP_MINIMAX_NO_DEADLINE);
+		threads[nCopies].search.handle = handle;
+		threads[nCopies].search.ybwc = &ybwc;
+		threads[nCopies].search.threadId = nCopies;
+		threads[nCopies].ybwc = &ybwc;
+		pthread_mutex_init(&ybwc.deques[nCopies].lock, NULL);
+	}
+	if (nCopies == (int)nThreads){
+		ybwc.nThreads = nThreads;
+		ybwc.nIdle = 0;
+		ybwc.done = 0;
+		for (int i=1; i<(int)nThreads; i++){
+			__atomic_add_fetch(&ybwc.nIdle, 1, __ATOMIC_RELAXED);
+			threads[i].isStarted = (pthread_create(&threads[i].thread, NULL, ybwcHelperMain, &threads[i]) == 0);
+			if (!threads[i].isStarted){
+				__atomic_sub_fetch(&ybwc.nIdle, 1, __ATOMIC_RELAXED);
+			}
+		}
+		bool isMax = (src->currentPlayer == SP_CHESS_GAME_BLACK);
+		spMiniMaxAlphaBeta(&threads[0].search, threads[0].game, depth, isMax, INT_MIN, INT_MAX, &bestMove);
+		__atomic_store_n(&ybwc.done, 1, __ATOMIC_RELAXED);
+		addStats(&threads[0].search);
+		for (int i=1; i<(int)nThreads; i++){
+			if (threads[i].isStarted){
+				pthread_join(threads[i].thread, NULL);
+			}
+		}
+		if (!threads[0].search.stopped){
+			reportProgress(&threads[0].search, depth, bestMove);
+		}
+	}
+	for (int i=0; i<nCopies; i++){
+		spChessGameDestroy(threads[i].game);
+		pthread_mutex_destroy(&ybwc.deques[i].lock);
+	}
+	free(ybwc.deques);
+	free(threads);
+	return spChessGameUnpackMove(bestMove);
+}
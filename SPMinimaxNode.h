@@ -1,21 +1,295 @@
 #ifndef SPMINIMAXNODE_H_
 #define SPMINIMAXNODE_H_
 
+#include <pthread.h>
+#include <signal.h>
 #include "SPChessGame.h"
+#include "SPTransTable.h"
+
+//Definitions
+#define SP_MINIMAX_MAX_PLY 64
+#define SP_MINIMAX_NO_DEADLINE -1
+#define SP_MINIMAX_NO_TIME_LIMIT 0
+#define SP_MINIMAX_TIME_CHECK_INTERVAL 1024 //number of nodes searched between two reads of the clock and the handle
+#define SP_MINIMAX_N_KILLERS 2
+//move ordering scores: hash move, then captures, then killers, then by history
+#define SP_MINIMAX_HASH_MOVE_SCORE 0x40000000
+#define SP_MINIMAX_CAPTURE_SCORE 0x20000000
+#define SP_MINIMAX_KILLER_SCORE 0x10000000
+#define SP_MINIMAX_MAX_HISTORY_SCORE 0x08000000
+#define SP_MINIMAX_VICTIM_WEIGHT 128 //greater than the score of any attacker
+#define SP_MINIMAX_MIN_SPLIT_DEPTH 3 //nodes closer to the leaves are always searched by a single thread
+#define SP_MINIMAX_DELTA_MARGIN (2*SP_CHESS_GAME_SCORE_UNIT) //captures which can't raise the score above alpha by this margin are skipped
+
+/**
+ * Type used to hold the statistics of a search, summed over all its threads.
+ * The cut-offs and the moves searched are counted in the full width search, without the quiescence search.
+ */
+typedef struct sp_minimax_stats_t {
+	unsigned long long nodes; //the nodes searched, including the quiescence search
+	unsigned long long leafEvals; //the positions evaluated by the scoring function
+	unsigned long long interiorNodes; //the nodes whose moves were searched
+	unsigned long long movesSearched; //the moves searched from these nodes
+	unsigned long long betaCutoffs; //the nodes cut off by one of their moves
+	unsigned long long firstMoveCutoffs; //the cut-offs caused by the first move searched
+	unsigned long long ttProbes; //the probes of the transposition table, 0 if there's no table
+	unsigned long long ttHits; //the probes which have found the position
+	int depth; //the depth of the deepest completed search
+	int maxPly; //the deepest ply reached, including the quiescence search
+	long long elapsedMs; //the time of the search in ms
+} SPMinimaxStats;
+
+/**
+ * Type of a function called by a search each time it completes a depth
+ *
+ * @param depth - the depth completed
+ * @param bestMove - the best move found at this depth
+ * @param nodes - the number of nodes searched so far by all the threads of the search
+ * @param data - the progressData of the handle of the search
+ */
+typedef void (*SPMinimaxProgressFunc)(int depth, SPMove bestMove, unsigned long long nodes, void *data);
+
+/**
+ * Type used to control a search from outside of it. The search can be stopped by another thread
+ * (or a signal handler), and then it returns the best move it has found so far.
+ */
+typedef struct sp_minimax_handle_t {
+	//set to stop the search, read once every SP_MINIMAX_TIME_CHECK_INTERVAL nodes.
+	//sig_atomic_t so it may be set by a signal handler, and accessed atomically since other threads read it
+	volatile sig_atomic_t stop;
+	SPMinimaxStats stats; //the statistics of the search, nodes is counted while searching (accessed atomically)
+	SPMinimaxProgressFunc progress; //called after every completed depth, or NULL
+	void *progressData; //passed to progress
+} SPMinimaxHandle;
+
+/**
+ * Type used to hold the state of a single search.
+ * The moves made on the way from the root to the current node are recorded in undoStack,
+ * so the search never touches the moves history of the game.
+ * killers and history are used to order the quiet moves (moves that don't capture)
+ * by the cut-offs they have caused in earlier nodes of the search.
+ */
+typedef struct sp_minimax_search_t {
+	SPUndoInfo undoStack[SP_MINIMAX_MAX_PLY];
+	int ply; //the distance of the current node from the root
+	SPTransTable *transTable; //the positions searched so far, or NULL if there's no table
+	long long deadline; //the time in ms at which the search stops, or SP_MINIMAX_NO_DEADLINE
+	unsigned int nodes; //the number of nodes searched
+	unsigned int countedNodes; //the number of nodes already added to the handle
+	SPMinimaxStats stats; //the statistics of the thread not yet added to the handle, other than nodes
+	bool stopped; //true if the search has been stopped before it was completed
+	const int *stopFlag; //set by another thread to stop the search, or NULL
+	SPMinimaxHandle *handle; //the handle of the search, or NULL
+	struct sp_minimax_ybwc_t *ybwc; //the shared state of a YBWC search, or NULL for a serial search
+	int threadId; //the index of the thread in a parallel search
+	struct sp_minimax_split_point_t *splitPoint; //the split point the thread is searching moves of, or NULL
+	SPPackedMove killers[SP_MINIMAX_MAX_PLY][SP_MINIMAX_N_KILLERS]; //the last quiet moves which caused a cut-off at each ply
+	int history[2][SP_BITBOARD_N_SQUARES][SP_BITBOARD_N_SQUARES]; //[color][start][dest] - weighted cut-offs of quiet moves
+} SPMinimaxSearch;
+
+/**
+ * Type used to hold the state of a thread of a parallel search
+ */
+typedef struct sp_minimax_thread_t {
+	SPMinimaxSearch search;
+	SPChessGame *game; //the thread's own copy of the game
+	int firstDepth; //the depth of the first iteration
+	int maxDepth; //the depth of the last iteration
+	long long deadline; //the time in ms at which the search stops, or SP_MINIMAX_NO_DEADLINE
+	SPPackedMove bestMove; //the best move of the deepest iteration, which may have been stopped
+	int completedDepth; //the depth of the deepest completed iteration, 0 if there's none
+	pthread_t thread;
+	bool isStarted; //true if the thread has been created
+} SPMinimaxThread;
+
+/**
+ * Type used to hold the state of a search on the opponent's time (pondering):
+ * the position after the predicted move of the user is searched in the background
+ */
+typedef struct sp_minimax_ponder_t {
+	SPChessGame *game; //the position after the predicted move
+	uint64_t key; //the Zobrist key of game
+	int depth; //the depth of the search
+	unsigned int nThreads; //the number of threads of the search
+	int parallelMode; //the SP_MINIMAX_PARALLEL_MODE of the search
+	SPTransTable *transTable;
+	SPMove bestMove; //the best reply found by the search
+	SPMinimaxHandle handle; //stops the search, its stats.depth is set once the search is completed
+	int isDone; //set when the search is completed (accessed atomically)
+	pthread_t thread;
+	bool isActive; //true if the thread has been created and hasn't been joined yet
+} SPMinimaxPonder;
+
+/**
+ * Type used to represent a node of a YBWC search whose moves are searched by several threads.
+ * The fields below lock are protected by it, except for cutoff which is also read atomically
+ * by the threads searching below the node.
+ */
+typedef struct sp_minimax_split_point_t {
+	pthread_mutex_t lock;
+	struct sp_minimax_split_point_t *parent; //the split point the owner was searching for when it split, or NULL
+	SPChessGame position; //the position of the node, its recentMoves isn't used
+	int ply; //the distance of the node from the root
+	unsigned int depth; //the remaining depth of the node
+	bool isMax;
+	SPPackedMove moves[SP_CHESS_GAME_MAX_NUMBER_OF_ALL_MOVES]; //the moves left after the eldest brother, in search order
+	int size; //the number of moves
+	int nextIndex; //the index of the next move to be given to a thread
+	int a, b; //the window of the node, narrowed by every move searched
+	int bestScore;
+	SPPackedMove bestMove;
+	int nWorkers; //the number of threads searching moves of the node, including the owner
+	int cutoff; //set once a move has caused a cut-off, so the other moves are abandoned
+} SPMinimaxSplitPoint;
+
+/**
+ * Type used to hold the split points of a thread of a YBWC search.
+ * The owner pushes and pops split points at the bottom, and other threads look for work from the top,
+ * where the split points closest to the root (and so with the most work) are.
+ */
+typedef struct sp_minimax_split_deque_t {
+	pthread_mutex_t lock;
+	SPMinimaxSplitPoint *splitPoints[SP_MINIMAX_MAX_PLY];
+	int size;
+} SPMinimaxSplitDeque;
+
+/**
+ * Type used to hold the state shared by all the threads of a YBWC search
+ */
+typedef struct sp_minimax_ybwc_t {
+	SPMinimaxSplitDeque *deques; //[threadId] - the split points of each thread
+	int nThreads;
+	int nIdle; //the number of threads looking for work (accessed atomically)
+	int done; //set when the root has been searched, to stop the helpers (accessed atomically)
+} SPMinimaxYBWC;
+
+/**
+ * Type used to hold the state of a thread of a YBWC search
+ */
+typedef struct sp_minimax_ybwc_thread_t {
+	SPMinimaxSearch search;
+	SPChessGame *game; //the thread's own game, set to the position of every split point it joins
+	SPMinimaxYBWC *ybwc;
+	pthread_t thread;
+	bool isStarted; //true if the thread has been created
+} SPMinimaxYBWCThread;
+
+/**
+ * Type used to hold the state of a worker of a root split search
+ */
+typedef struct sp_minimax_root_worker_t {
+	SPMinimaxSearch search;
+	SPChessGame *game; //the worker's own copy of the game
+	const SPPackedMove *moves; //the ordered root moves, shared by all the workers
+	int nMoves; //the number of root moves
+	int firstIndex; //the worker searches the moves firstIndex, firstIndex+step, firstIndex+2*step...
+	int step;
+	int depth; //the depth of the search from the root
+	int bestScore; //the score of the best move the worker has searched
+	int bestIndex; //the index of the best move the worker has searched, -1 if there's none
+	pthread_t thread;
+	bool isStarted; //true if the thread has been created
+} SPMinimaxRootWorker;
+
+/** Returns the time of a monotonic clock in milliseconds
+ * @return
+ * the current time in ms
+ * */
+long long spMiniMaxGetTimeMs();
 
 /**
  * Given a game state, this function evaluates the best move according to
  * the current player. The function initiates a MiniMax algorithm using alpha beta puirning up to a
  * specified length given by maxDepth. The current game state doesn't change
  * by this function including the history of previous moves.
+ * The results of the search are stored in transTable and are used
+ * to cut off and order the moves of positions that were already searched.
  *
  * @param currentGame - The current game state
  * @param maxDepth - The maximum depth of the miniMax algorithm
+ * @param transTable - The transposition table, or NULL to search without it
+ * @param handle - The handle to stop the search and get its progress, or NULL
+ * @return
+ * {{-1,-1},{-1,-1},0,0} if a memory allocation error has occurred.
+ * On success the function returns a valid move
+ * which is the best move for the current player, or the best move found so far if the search is stopped.
+ */
+SPMove spMiniMax (SPChessGame* src, int depth, SPTransTable *transTable, SPMinimaxHandle *handle);
+
+/**
+ * Given a game state, this function evaluates the best move according to
+ * the current player, by searching to depth 1, 2, 3... up to maxDepth
+ * until the specified time has passed. The current game state doesn't change
+ * by this function including the history of previous moves.
+ *
+ * The search runs on nThreads threads (Lazy SMP). Every thread searches the same root
+ * on its own copy of the game, and the threads share only the transposition table,
+ * so the work of one thread cuts off and orders the search of the others.
+ * Every other helper starts at depth 2 instead of depth 1, so the threads are
+ * spread over different iterations. The helpers are stopped once the main thread is done,
+ * and the best move of the deepest iteration completed by any thread is returned
+ * (the main thread's move on a tie).
+ *
+ * @param src - The current game state
+ * @param maxDepth - The maximum depth of the miniMax algorithm
+ * @param timeMs - The time limit of the search in milliseconds, or SP_MINIMAX_NO_TIME_LIMIT
+ * @param nThreads - The number of threads, if a helper can't be created the search runs without it
+ * @param transTable - The transposition table, or NULL to search without it
+ * @param handle - The handle to stop the search and get its progress, or NULL
+ * @param completedDepth - If not NULL, pointer to get the depth of the deepest completed iteration,
+ *                         0 if the search has been stopped before any iteration was completed
+ * @return
+ * {{-1,-1},{-1,-1},0,0} if a memory allocation error has occurred.
+ * Otherwise the function returns a valid move which is the best move for the current player.
+ * If the last iteration is stopped, its best move so far is returned.
+ */
+SPMove spMiniMaxIterative (SPChessGame* src, int maxDepth, unsigned int timeMs, unsigned int nThreads, SPTransTable *transTable,
+		SPMinimaxHandle *handle, int *completedDepth);
+
+/**
+ * Given a game state, this function evaluates the best move according to
+ * the current player, by splitting the moves of the root between nThreads workers.
+ * The current game state doesn't change by this function including the history of previous moves.
+ *
+ * The root moves are ordered once, and worker i searches the moves i, i+nThreads, i+2*nThreads...
+ * to the specified depth on its own copy of the game, with its own alpha beta window
+ * and without a transposition table. The best move is the first move in the root order
+ * which has the highest score, so the result doesn't depend on the timing of the threads.
+ *
+ * @param src - The current game state
+ * @param depth - The maximum depth of the miniMax algorithm
+ * @param nThreads - The number of workers, a worker whose thread can't be created
+ *                   is run by the calling thread
+ * @param handle - The handle to stop the search and get its progress, or NULL
+ * @return
+ * {{-1,-1},{-1,-1},0,0} if a memory allocation error has occurred.
+ * On success the function returns a valid move
+ * which is the best move for the current player, or the best move found so far if the search is stopped.
+ */
+SPMove spMiniMaxRootSplit (SPChessGame* src, int depth, unsigned int nThreads, SPMinimaxHandle *handle);
+
+/**
+ * Given a game state, this function evaluates the best move according to
+ * the current player, by a parallel alpha beta search to the specified depth
+ * using the Young Brothers Wait Concept. The current game state doesn't change
+ * by this function including the history of previous moves.
+ *
+ * A node is searched by a single thread until its first move (the eldest brother) has been searched.
+ * Then, if the node is at least SP_MINIMAX_MIN_SPLIT_DEPTH from the leaves and a thread is idle,
+ * the node becomes a split point on the deque of its thread, and idle threads steal it
+ * and search its other moves on their own game. A thread that waits for the helpers of its split point
+ * helps them with split points below its own. The threads share transTable.
+ *
+ * @param src - The current game state
+ * @param depth - The maximum depth of the miniMax algorithm
+ * @param nThreads - The number of threads, if a helper can't be created the search runs without it
+ * @param transTable - The transposition table, or NULL to search without it
+ * @param handle - The handle to stop the search and get its progress, or NULL
  * @return
  * {{-1,-1},{-1,-1},0,0} if a memory allocation error has occurred.
  * On success the function returns a valid move
- * which is the best move for the current player.
+ * which is the best move for the current player, or the best move found so far if the search is stopped.
  */
-SPMove spMiniMax (SPChessGame* src, int depth);
+SPMove spMiniMaxYBWC (SPChessGame* src, int depth, unsigned int nThreads, SPTransTable *transTable, SPMinimaxHandle *handle);
 
 #endif
@@ -0,0 +1,83 @@
+#ifndef SPPACKEDMOVE_H_
+#define SPPACKEDMOVE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * SPPackedMove Summary:
+ *
+ * A move of the game packed into 16 bits, used by the search in its move lists,
+ * killer moves and transposition table entries instead of the larger SPMove.
+ * Bits 0-5 are the start square and bits 6-11 the destination square
+ * (numbered as in SPBitboard), bit 12 is set if the move captures a piece.
+ * A move never starts and ends on the same square, so 0 is used as SP_PACKED_MOVE_NONE.
+ *
+ * spPackedMoveCreate    - Packs a move
+ * spPackedMoveStart     - Returns the start square of a move
+ * spPackedMoveDest      - Returns the destination square of a move
+ * spPackedMoveIsCapture - Returns whether a move captures a piece
+ * spPackedMoveIsSame    - Checks if two moves have the same start and destination
+ */
+
+//Definitions
+#define SP_PACKED_MOVE_NONE ((SPPackedMove)0)
+#define SP_PACKED_MOVE_SQUARE_BITS 6
+#define SP_PACKED_MOVE_SQUARE_MASK 0x3F
+#define SP_PACKED_MOVE_SQUARES_MASK 0x0FFF
+#define SP_PACKED_MOVE_CAPTURE 0x1000
+
+/**
+ * Type used to represent a packed move
+ */
+typedef uint16_t SPPackedMove;
+
+/** Packs the specified move
+ * @param start - the start square
+ * @param dest - the destination square
+ * @param isCapture - whether the move captures a piece
+ * @return
+ * the packed move
+ */
+static inline SPPackedMove spPackedMoveCreate(int start, int dest, bool isCapture){
+	return (SPPackedMove)(start | (dest << SP_PACKED_MOVE_SQUARE_BITS) | (isCapture ? SP_PACKED_MOVE_CAPTURE : 0));
+}
+
+/** Returns the start square of the specified move
+ * @param move - the packed move
+ * @return
+ * the start square
+ */
+static inline int spPackedMoveStart(SPPackedMove move){
+	return move & SP_PACKED_MOVE_SQUARE_MASK;
+}
+
+/** Returns the destination square of the specified move
+ * @param move - the packed move
+ * @return
+ * the destination square
+ */
+static inline int spPackedMoveDest(SPPackedMove move){
+	return (move >> SP_PACKED_MOVE_SQUARE_BITS) & SP_PACKED_MOVE_SQUARE_MASK;
+}
+
+/** Returns whether the specified move captures a piece
+ * @param move - the packed move
+ * @return
+ * true if the capture bit of the move is set
+ */
+static inline bool spPackedMoveIsCapture(SPPackedMove move){
+	return (move & SP_PACKED_MOVE_CAPTURE) != 0;
+}
+
+/** Checks if two moves have the same start and destination, regardless of their flags
+ * @param move1, move2 - the packed moves
+ * @return
+ * true - if the moves are the same
+ * false - otherwise
+ */
+static inline bool spPackedMoveIsSame(SPPackedMove move1, SPPackedMove move2){
+	return ((move1 ^ move2) & SP_PACKED_MOVE_SQUARES_MASK) == 0;
+}
+
+#endif /* SPPACKEDMOVE_H_ */
@@ -0,0 +1,164 @@
+#include "SPTransTable.h"
+#include <stdlib.h>
+
+#define BYTES_IN_MB (1024*1024)
+
+/********************Prototypes**************************/
+
+uint64_t packEntry(const SPTransTableEntry *entry);
+void unpackEntry(uint64_t data, SPTransTableEntry *entry);
+
+/*******************Implementation***********************/
+
+/** Packs the fields of the specified entry into one word:
+ * bits 0-31 the score, bits 32-39 the depth+1 (0 for an empty slot), bits 40-47 the bound,
+ * and bits 48-63 the best move.
+ *
+ * @param entry - the entry
+ * @return
+ * the packed entry
+ */
+uint64_t packEntry(const SPTransTableEntry *entry){
+	return (uint64_t)(uint32_t)entry->score |
+			((uint64_t)(uint8_t)(entry->depth+1) << 32) |
+			((uint64_t)entry->bound << 40) |
+			((uint64_t)entry->move << 48);
+}
+
+/** Unpacks a word packed by packEntry
+ *
+ * @param data - the packed entry
+ * @param entry - pointer to get the entry
+ */
+void unpackEntry(uint64_t data, SPTransTableEntry *entry){
+	entry->score = (int32_t)(uint32_t)data;
+	entry->depth = (int)((data >> 32) & 0xFF) - 1;
+	entry->bound = (SP_TRANS_TABLE_BOUND)((data >> 40) & 0xFF);
+	entry->move = (SPPackedMove)(data >> 48);
+}
+
+/**
+ * Creates an empty table which takes at most the specified size in MB.
+ * The number of entries is the largest power of two that fits in this size.
+ *
+ * @param sizeMB - the size of the table in MB
+ * @return
+ * NULL if either a memory allocation failure occurs or sizeMB <= 0.
+ * Otherwise, a new table is returned.
+ */
+SPTransTable* spTransTableCreate(int sizeMB){
+	if (sizeMB <= 0){
+		return NULL;
+	}
+	uint64_t maxSlots = ((uint64_t)sizeMB * BYTES_IN_MB) / sizeof(SPTransTableSlot);
+	uint64_t nSlots = 1;
+	while (nSlots*2 <= maxSlots){
+		nSlots *= 2;
+	}
+	SPTransTable* table = (SPTransTable*) malloc(sizeof(SPTransTable));
+	if (!table){
+		return NULL;
+	}
+	table->slots = (SPTransTableSlot*) malloc(sizeof(SPTransTableSlot) * nSlots);
+	if (!table->slots){
+		free(table);
+		return NULL;
+	}
+	table->mask = nSlots-1;
+	spTransTableClear(table);
+	return table;
+}
+
+/**
+ * Frees all memory allocation associated with a given table. If src==NULL
+ * the function does nothing.
+ *
+ * @param src - the source table
+ */
+void spTransTableDestroy(SPTransTable* src){
+	if (!src){
+		return;
+	}
+	free(src->slots);
+	free(src);
+}
+
+/**
+ * Removes all the entries from the specified table.
+ * Must not be called while the table is searched.
+ *
+ * @param src - the source table
+ */
+void spTransTableClear(SPTransTable* src){
+	//a slot with packed depth 0 is never used by the search
+	for (uint64_t i=0; i<=src->mask; i++){
+		src->slots[i].check = 0;
+		src->slots[i].data = 0;
+	}
+}
+
+/**
+ * Returns the entry of the position with the specified key
+ *
+ * @param src - the source table
+ * @param key - the Zobrist key of the position
+ * @param entry - pointer to get the entry of the position
+ * @return
+ * true - if the table contains the position
+ * false - otherwise
+ */
+bool spTransTableProbe(SPTransTable* src, uint64_t key, SPTransTableEntry *entry){
+	SPTransTableSlot *slot = &src->slots[key & src->mask];
+	uint64_t check = __atomic_load_n(&slot->check, __ATOMIC_RELAXED);
+	uint64_t data = __atomic_load_n(&slot->data, __ATOMIC_RELAXED);
+	if ((check ^ data) != key){
+		return false;
+	}
+	unpackEntry(data, entry);
+	return entry->depth >= 0;
+}
+
+/**
+ * Stores the result of searching the position with the specified key.
+ * The entry of a different position that has the same index is replaced.
+ * An entry of the same position is replaced only by a search which is at least as deep.
+ *
+ * @param src - the source table
+ * @param key - the Zobrist key of the position
+ * @param depth - the depth of the search
+ * @param bound - the type of the score
+ * @param score - the score of the search
+ * @param bestMove - the best move found, or SP_PACKED_MOVE_NONE if there's none
+ */
+void spTransTableStore(SPTransTable* src, uint64_t key, int depth, SP_TRANS_TABLE_BOUND bound, int score, SPPackedMove bestMove){
+	SPTransTableSlot *slot = &src->slots[key & src->mask];
+	SPTransTableEntry entry;
+	uint64_t data;
+	if (spTransTableProbe(src, key, &entry) && entry.depth > depth){
+		return;
+	}
+	entry.depth = depth;
+	entry.bound = bound;
+	entry.score = score;
+	entry.move = bestMove;
+	data = packEntry(&entry);
+	__atomic_store_n(&slot->check, key ^ data, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->data, data, __ATOMIC_RELAXED);
+}
+
+/**
+ * Returns the best move kept in the specified entry
+ *
+ * @param entry - the entry
+ * @param move - pointer to get the move
+ * @return
+ * true - if the entry contains a best move
+ * false - otherwise
+ */
+bool spTransTableGetMove(const SPTransTableEntry* entry, SPPackedMove *move){
+	if (entry->move == SP_PACKED_MOVE_NONE){
+		return false;
+	}
+	*move = entry->move;
+	return true;
+}
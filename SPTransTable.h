@@ -0,0 +1,127 @@
+#ifndef SPTRANSTABLE_H_
+#define SPTRANSTABLE_H_
+
+#include <stdint.h>
+#include "SPChessGame.h"
+
+/**
+ * SPTransTable Summary:
+ *
+ * A fixed size hash table of positions that have already been searched,
+ * indexed by the Zobrist key of the position. The number of entries is a power of two,
+ * so the entry of a key is found by masking its low bits.
+ * Every entry keeps the result of searching its position: the depth searched,
+ * the score, whether the score is exact or a bound, and the best move found.
+ *
+ * The table may be shared by several searching threads without locks. The fields of an entry
+ * are packed into one 64 bit word which is stored next to the key xored with it,
+ * so an entry which was torn by two threads writing at the same time doesn't match its key
+ * and is ignored as a miss.
+ *
+ * spTransTableCreate   - Creates a table of the specified size in MB
+ * spTransTableDestroy  - Frees all memory resources associated with a table
+ * spTransTableClear    - Removes all the entries from a table
+ * spTransTableProbe    - Returns the entry of a position
+ * spTransTableStore    - Stores the result of searching a position
+ * spTransTableGetMove  - Returns the best move kept in an entry
+ */
+
+/**
+ * Type of the score kept in an entry, relatively to the alpha beta window it was searched with
+ */
+typedef enum sp_trans_table_bound_t {
+	SP_TRANS_TABLE_EXACT, //the score is the exact minimax score of the position
+	SP_TRANS_TABLE_LOWER, //the minimax score of the position is at least the score
+	SP_TRANS_TABLE_UPPER  //the minimax score of the position is at most the score
+} SP_TRANS_TABLE_BOUND;
+
+/**
+ * Type used to represent the result of searching a position, as returned by spTransTableProbe
+ */
+typedef struct sp_trans_table_entry_t {
+	int score;
+	int depth;
+	SP_TRANS_TABLE_BOUND bound;
+	SPPackedMove move; //the best move, SP_PACKED_MOVE_NONE if there's none
+} SPTransTableEntry;
+
+/**
+ * Type used to represent a slot of the table, as it is kept in memory
+ */
+typedef struct sp_trans_table_slot_t {
+	uint64_t check; //the Zobrist key of the position xored with data
+	uint64_t data; //the fields of the entry packed by packEntry
+} SPTransTableSlot;
+
+/**
+ * Type used to represent a transposition table
+ */
+typedef struct sp_trans_table_t {
+	SPTransTableSlot *slots;
+	uint64_t mask; //number of slots - 1
+} SPTransTable;
+
+/**
+ * Creates an empty table which takes at most the specified size in MB.
+ * The number of entries is the largest power of two that fits in this size.
+ *
+ * @param sizeMB - the size of the table in MB
+ * @return
+ * NULL if either a memory allocation failure occurs or sizeMB <= 0.
+ * Otherwise, a new table is returned.
+ */
+SPTransTable* spTransTableCreate(int sizeMB);
+
+/**
+ * Frees all memory allocation associated with a given table. If src==NULL
+ * the function does nothing.
+ *
+ * @param src - the source table
+ */
+void spTransTableDestroy(SPTransTable* src);
+
+/**
+ * Removes all the entries from the specified table
+ *
+ * @param src - the source table
+ */
+void spTransTableClear(SPTransTable* src);
+
+/**
+ * Returns the entry of the position with the specified key
+ *
+ * @param src - the source table
+ * @param key - the Zobrist key of the position
+ * @param entry - pointer to get the entry of the position
+ * @return
+ * true - if the table contains the position
+ * false - otherwise
+ */
+bool spTransTableProbe(SPTransTable* src, uint64_t key, SPTransTableEntry *entry);
+
+/**
+ * Stores the result of searching the position with the specified key.
+ * The entry of a different position that has the same index is replaced.
+ * An entry of the same position is replaced only by a search which is at least as deep.
+ *
+ * @param src - the source table
+ * @param key - the Zobrist key of the position
+ * @param depth - the depth of the search
+ * @param bound - the type of the score
+ * @param score - the score of the search
+ * @param bestMove - the best move found, or SP_PACKED_MOVE_NONE if there's none
+ */
+void spTransTableStore(SPTransTable* src, uint64_t key, int depth, SP_TRANS_TABLE_BOUND bound, int score, SPPackedMove bestMove);
+
+/**
+ * Returns the best move kept in the specified entry
+ *
+ * @param entry - the entry
+ * @param move - pointer to get the move
+ * @return
+ * true - if the entry contains a best move
+ * false - otherwise
+ */
+bool spTransTableGetMove(const SPTransTableEntry* entry, SPPackedMove *move);
+
+#endif /* SPTRANSTABLE_H_ */
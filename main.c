@@ -1,15 +1,29 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 #include "ConsoleMode.h"
 #include "GUI_Manager.h"
+#include "SPMinimax.h"
 
 int main(int argc, char *argv[]){
+	bool isGui = false;
 
 	if (argc==0){
 		printf("%s",argv[0]);
 	}
 
-	if (argc == 2 && strcmp(argv[1],"-g")==0){
+	//"-g" for GUI mode, "-t <n>" to search on n threads (0 for all the processors), one thread by default
+	for (int i=1; i<argc; i++){
+		if (strcmp(argv[i],"-g")==0){
+			isGui = true;
+		}
+		else if (strcmp(argv[i],"-t")==0 && i+1<argc && atoi(argv[i+1])>=0){
+			spMinimaxSetThreads((unsigned int)atoi(argv[++i]));
+		}
+	}
+
+	if (isGui){
 		guiMain();
 	}
 	else {
@@ -19,4 +33,3 @@ int main(int argc, char *argv[]){
 	//status is SP_GAME_STATUS_QUIT
 	return 1;
 }
-